@@ -0,0 +1,138 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Helpers for compact binary serialization of simulation data (recordings, checkpoints, rasters).
+// Values are written in the host byte order, so blobs are meant to be read back on the same kind of machine.
+
+// Growable byte buffer with typed, varint and bulk writes.
+class BinaryWriter {
+    std::vector<uint8_t> buffer_;
+
+public:
+    template<typename T>
+    void Write(T value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written");
+        WriteBytes(&value, sizeof(T));
+    }
+
+    void WriteBytes(const void* data, std::size_t size) {
+        if (size == 0) return;
+        std::size_t offset = buffer_.size();
+        buffer_.resize(offset + size);
+        std::memcpy(buffer_.data() + offset, data, size);
+    }
+
+    // LEB128 encoding, small numbers (run lengths, step deltas) take a single byte.
+    void WriteVarUInt(uint64_t value) {
+        while (value >= 0x80) {
+            buffer_.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        buffer_.push_back(static_cast<uint8_t>(value));
+    }
+
+    void Reserve(std::size_t size) { buffer_.reserve(size); }
+    void Clear() { buffer_.clear(); }
+    std::size_t Size() const { return buffer_.size(); }
+    const std::vector<uint8_t>& GetBuffer() const { return buffer_; }
+    std::vector<uint8_t> TakeBuffer() { return std::move(buffer_); }
+};
+
+// Sequential reader over a byte range produced by BinaryWriter. Throws when reading past the end.
+class BinaryReader {
+    const uint8_t* data_;
+    std::size_t size_;
+    std::size_t position_ = 0;
+
+public:
+    BinaryReader(const uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+    explicit BinaryReader(const std::vector<uint8_t>& buffer) : BinaryReader(buffer.data(), buffer.size()) {}
+
+    template<typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read");
+        T value;
+        ReadBytes(&value, sizeof(T));
+        return value;
+    }
+
+    void ReadBytes(void* data, std::size_t size) {
+        if (size > size_ - position_) {
+            throw std::runtime_error("Unexpected end of binary data");
+        }
+        if (size == 0) return;
+        std::memcpy(data, data_ + position_, size);
+        position_ += size;
+    }
+
+    uint64_t ReadVarUInt() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = Read<uint8_t>();
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Malformed variable-length integer");
+    }
+
+    bool AtEnd() const { return position_ == size_; }
+    std::size_t Remaining() const { return size_ - position_; }
+};
+
+// Run-length encodes a plane as (run length, value) pairs. Fire state planes are mostly uniform, so this shrinks them a lot.
+template<typename T>
+void WriteRunLength(BinaryWriter& writer, const T* values, std::size_t count) {
+    writer.WriteVarUInt(count);
+    std::size_t i = 0;
+    while (i < count) {
+        std::size_t run = 1;
+        while (i + run < count && values[i + run] == values[i]) {
+            ++run;
+        }
+        writer.WriteVarUInt(run);
+        writer.Write<T>(values[i]);
+        i += run;
+    }
+}
+
+// Decodes a plane written by WriteRunLength into the given output buffer, which must have the encoded size.
+template<typename T>
+void ReadRunLength(BinaryReader& reader, T* values, std::size_t count) {
+    if (reader.ReadVarUInt() != count) {
+        throw std::runtime_error("Run-length plane has an unexpected size");
+    }
+    std::size_t i = 0;
+    while (i < count) {
+        std::size_t run = reader.ReadVarUInt();
+        T value = reader.Read<T>();
+        if (run == 0 || run > count - i) {
+            throw std::runtime_error("Malformed run-length plane");
+        }
+        std::fill(values + i, values + i + run, value);
+        i += run;
+    }
+}
+
+// Packs a plane of flags into 64-bit words, one bit per tile. isSet(i) tells whether tile i has the flag.
+template<typename Predicate>
+std::vector<uint64_t> PackBits(std::size_t count, Predicate isSet) {
+    std::vector<uint64_t> words((count + 63) / 64, 0);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (isSet(i)) {
+            words[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+    return words;
+}
+
+inline bool GetPackedBit(const std::vector<uint64_t>& words, std::size_t index) {
+    return (words[index / 64] >> (index % 64)) & 1u;
+}
@@ -0,0 +1,112 @@
+#include <SFML/Graphics.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "ensembleSimulation.h"
+#include "scenario.h"
+#include "worldGenerator.h"
+
+// Burn probability maps for the scenarios of a scenario file, see ensembleSimulation.h. Water ignitions are left out, the wind is the one of
+// the first wind entry and the fire runs until it is out. Later wind entries and weather are not supported and only warned about, and
+// spread chances are quantized to 16 bits. --compare=N (256 without a value) also runs N independent SpreadKernel realizations and
+// reports their time per realization and the mean difference of the two maps.
+// Usage: fireBurnProbability <scenario file> <output directory> [--realizations=1024] [--threads=N] [--compare[=256]]
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <scenario file> <output directory> [--realizations=1024] [--threads=N] [--compare[=256]]\n"
+                  << "Runs under the constant wind of the first wind entry, with spread chances quantized to 16 bits." << std::endl;
+        return 1;
+    }
+
+    try {
+        int realizations = 1024;
+        int compareRealizations = 0;
+        std::size_t threads = std::thread::hardware_concurrency();
+        for (int i = 3; i < argc; ++i) {
+            std::string option = argv[i];
+            std::size_t equals = option.find('=');
+            std::string key = option.substr(0, equals);
+            std::string value = equals == std::string::npos ? "" : option.substr(equals + 1);
+            try {
+                if (key == "--realizations") {
+                    realizations = std::stoi(value);
+                } else if (key == "--threads") {
+                    threads = std::stoul(value);
+                } else if (key == "--compare") {
+                    compareRealizations = value.empty() ? 256 : std::stoi(value);
+                } else {
+                    throw std::runtime_error("Unknown option: " + option);
+                }
+            } catch (const std::logic_error&) { // std::stoi and std::stoul on a value that is not a number
+                throw std::runtime_error("Option " + key + " needs a number, e.g. " + key + "=256, got: " + option);
+            }
+        }
+
+        std::filesystem::path scenarioPath(argv[1]);
+        std::filesystem::create_directories(argv[2]);
+        TaskScheduler scheduler(threads);
+        for (const auto& scenario : ScenarioFile::Load(scenarioPath.string(), scenarioPath.stem().string())) {
+            WorldGenerator generator(scenario.worldSize, scenario.worldSize, scenario.lakeThreshold, scenario.rivers, scenario.worldSeed);
+            auto world = generator.Generate();
+            TerrainPlanes terrain = world->GetTerrainPlanes();
+            if (scenario.wind.size() > 1 || !scenario.weather.IsEmpty()) {
+                std::cerr << scenario.name << ": wind changes and weather are not supported, the wind of the first entry is used throughout" << std::endl;
+            }
+            float windSpeed = scenario.wind.empty() ? 5.0f : scenario.wind[0].speed;
+            int windDirection = scenario.wind.empty() ? 0 : scenario.wind[0].direction;
+
+            std::vector<uint32_t> ignitions;
+            for (const auto& [x, y] : scenario.ignitions) {
+                if (x < 0 || x >= terrain.width || y < 0 || y >= terrain.depth) {
+                    throw std::runtime_error(scenario.name + ": ignition " + std::to_string(x) + "," + std::to_string(y) + " is outside the world");
+                }
+                std::size_t tile = static_cast<std::size_t>(x) * terrain.depth + y;
+                if (terrain.moisture[tile] != 100) {
+                    ignitions.push_back(static_cast<uint32_t>(tile));
+                }
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            BurnProbabilityMap map = BurnProbabilityEnsemble(terrain, scheduler).Run(ignitions, realizations, scenario.seed, windSpeed, windDirection);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::ofstream grid(std::string(argv[2]) + "/" + scenario.name + ".burnprob.asc");
+            map.WriteAsciiGrid(grid);
+            std::cout << scenario.name << ": " << realizations << " realizations in " << seconds << " s (" << seconds / realizations * 1000
+                      << " ms each)" << std::endl;
+
+            if (compareRealizations > 0) {
+                using Kernel = SpreadKernel<MooreNeighborhood, DirectionalWind, StepSlope, CounterRng, CompactState>;
+                Kernel kernel(terrain, scenario.seed);
+                std::vector<uint32_t> counts(terrain.Size(), 0);
+                start = std::chrono::steady_clock::now();
+                for (int realization = 0; realization < compareRealizations; ++realization) {
+                    kernel.Reseed(scenario.seed + static_cast<uint32_t>(realization));
+                    kernel.Reset(*world);
+                    kernel.Ignite(ignitions);
+                    while (!kernel.HasEnded()) {
+                        kernel.Step(windSpeed, windDirection);
+                    }
+                    for (std::size_t tile = 0; tile < counts.size(); ++tile) {
+                        counts[tile] += kernel.GetState().Get(tile) != TileState::Unburned;
+                    }
+                }
+                double kernelSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                double difference = 0;
+                for (std::size_t tile = 0; tile < counts.size(); ++tile) {
+                    difference += std::abs(static_cast<double>(counts[tile]) / compareRealizations - map.probability[tile]);
+                }
+                std::cout << scenario.name << ": " << compareRealizations << " kernel realizations in " << kernelSeconds << " s ("
+                          << kernelSeconds / compareRealizations * 1000 << " ms each), mean probability difference "
+                          << difference / static_cast<double>(counts.size()) << std::endl;
+            }
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,123 @@
+#include <SFML/Graphics.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "distributedSimulation.h"
+#include "scenario.h"
+#include "worldGenerator.h"
+
+// Wind of the update producing the given step, with the same semantics as the scenario runner: entries take effect from their step on.
+static std::pair<float, int> GetWind(const std::vector<WindChange>& wind, int step) {
+    std::pair<float, int> current(5.0f, 0); // World defaults
+    for (const auto& change : wind) {
+        if (change.step > step) {
+            break;
+        }
+        current = {change.speed, change.direction};
+    }
+    return current;
+}
+
+// Runs the scenario in a single FireSpreadSimulation and compares the final state with the distributed result. Returns the mismatching tiles.
+static std::size_t Verify(const Scenario& scenario, const std::vector<uint32_t>& ignitions, const DistributedResult& result) {
+    WorldGenerator generator(scenario.worldSize, scenario.worldSize, scenario.lakeThreshold, scenario.rivers, scenario.worldSeed);
+    auto world = generator.Generate();
+    FireSpreadSimulation simulation(*world, scenario.seed);
+    std::vector<Tile*> startingTiles;
+    for (auto tile : ignitions) {
+        startingTiles.push_back(world->GetTileAt(static_cast<int>(tile) / world->GetDepth(), static_cast<int>(tile) % world->GetDepth()));
+    }
+    simulation.Initialize(startingTiles);
+
+    int steps = 0;
+    while (!simulation.HasEnded() && steps < scenario.maxSteps) {
+        auto [windSpeed, windDirection] = GetWind(scenario.wind, steps + 1);
+        world->GetParameter<float>("windSpeed")->SetValue(windSpeed);
+        world->GetParameter<int>("windDirection")->SetValue(windDirection);
+        simulation.Update();
+        steps++;
+    }
+
+    auto isBurning = world->GetVectorParameter<bool>("isBurning");
+    auto hasBurned = world->GetVectorParameter<bool>("hasBurned");
+    auto burningFor = world->GetVectorParameter<int>("burningFor");
+    auto ignitionTime = world->GetVectorParameter<int>("ignitionTime");
+    std::size_t mismatches = steps != result.steps;
+    for (std::size_t i = 0; i < isBurning->Size(); ++i) {
+        if (isBurning->GetValue(i) != static_cast<bool>(result.isBurning[i]) || hasBurned->GetValue(i) != static_cast<bool>(result.hasBurned[i]) ||
+            burningFor->GetValue(i) != result.burningFor[i] || ignitionTime->GetValue(i) != result.ignitionTimes[i]) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+// Runs the scenarios of a file in spread mode, split over several worker processes (see distributedSimulation.h). With --verify every
+// scenario is also run in a single process and the results are compared tile by tile.
+// Usage: fireDistributed <scenario file> [--workers=4] [--verify]
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <scenario file> [--workers=4] [--verify]" << std::endl;
+        return 1;
+    }
+
+    try {
+        int workers = 4;
+        bool verify = false;
+        for (int i = 2; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option.rfind("--workers=", 0) == 0) {
+                workers = std::stoi(option.substr(10));
+            } else if (option == "--verify") {
+                verify = true;
+            } else {
+                throw std::runtime_error("Unknown option: " + option);
+            }
+        }
+
+        std::filesystem::path scenarioPath(argv[1]);
+        bool allMatched = true;
+        for (const auto& scenario : ScenarioFile::Load(scenarioPath.string(), scenarioPath.stem().string())) {
+            if (scenario.mode != "spread" || !scenario.weather.IsEmpty() || scenario.spotting || !scenario.suppression.IsEmpty() || scenario.drying) {
+                throw std::runtime_error(scenario.name + ": distributed runs support spread mode without weather, spotting, suppression or drying");
+            }
+
+            std::vector<uint32_t> ignitions;
+            std::unique_ptr<DistributedSimulation> simulation;
+            {
+                // The world is only needed to build the terrain planes
+                WorldGenerator generator(scenario.worldSize, scenario.worldSize, scenario.lakeThreshold, scenario.rivers, scenario.worldSeed);
+                auto world = generator.Generate();
+                for (const auto& [x, y] : scenario.ignitions) {
+                    if (world->GetTileAt(x, y)->GetMoisture() != 100) { // Water is prohibited, as in the scenario runner
+                        ignitions.push_back(static_cast<uint32_t>(x * world->GetDepth() + y));
+                    }
+                }
+                simulation = std::make_unique<DistributedSimulation>(world->GetTerrainPlanes(), workers, scenario.seed);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            DistributedResult result = simulation->Run(ignitions, [&scenario](int step) { return GetWind(scenario.wind, step); }, scenario.maxSteps);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::size_t burned = 0;
+            for (std::size_t i = 0; i < result.hasBurned.size(); ++i) {
+                burned += result.hasBurned[i] || result.isBurning[i];
+            }
+            std::cout << scenario.name << ": " << result.steps << " steps, " << burned << " tiles burned by " << workers << " workers in "
+                      << seconds << " s";
+            if (verify) {
+                std::size_t mismatches = Verify(scenario, ignitions, result);
+                allMatched = allMatched && mismatches == 0;
+                std::cout << (mismatches == 0 ? ", matches the single-process run" : ", " + std::to_string(mismatches) + " tiles differ from the single-process run");
+            }
+            std::cout << std::endl;
+        }
+        return allMatched ? 0 : 2;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,528 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "policySimulation.h"
+
+// Rectangular part of the world owned by one worker, [fromX, toX) x [fromY, toY).
+struct Subdomain {
+    int fromX;
+    int toX;
+    int fromY;
+    int toY;
+
+    bool Contains(int x, int y) const {
+        return x >= fromX && x < toX && y >= fromY && y < toY;
+    }
+
+    // Upper bound of the ignition messages of one step: every halo tile once and every border tile once.
+    std::size_t GetMessageCapacity() const {
+        return static_cast<std::size_t>(4 * (toX - fromX + toY - fromY) + 4);
+    }
+
+    // Splits the world into a grid of workers subdomains, as close to square as the worker count allows.
+    static std::vector<Subdomain> Decompose(int width, int depth, int workers) {
+        if (workers < 1 || workers > width * depth) {
+            throw std::invalid_argument("Worker count must be between 1 and the number of tiles");
+        }
+        int columns = 1;
+        for (int candidate = 1; candidate * candidate <= workers; ++candidate) {
+            if (workers % candidate == 0) {
+                columns = candidate;
+            }
+        }
+        int rows = workers / columns;
+        if (rows > width || columns > depth) {
+            throw std::invalid_argument("Too many workers for the world size");
+        }
+
+        std::vector<Subdomain> subdomains;
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                subdomains.push_back({width * row / rows, width * (row + 1) / rows, depth * column / columns, depth * (column + 1) / columns});
+            }
+        }
+        return subdomains;
+    }
+
+    // Splits the world into bands of whole rows (along x), so consecutive workers own neighboring bands.
+    static std::vector<Subdomain> DecomposeRows(int width, int depth, int bands) {
+        if (bands < 1 || bands > width) {
+            throw std::invalid_argument("Band count must be between 1 and the world width");
+        }
+        std::vector<Subdomain> subdomains;
+        for (int band = 0; band < bands; ++band) {
+            subdomains.push_back({width * band / bands, width * (band + 1) / bands, 0, depth});
+        }
+        return subdomains;
+    }
+};
+
+// Read-only view of terrain planes, e.g. of TerrainPlanes or of a shared memory segment.
+struct TerrainView {
+    int width = 0;
+    int depth = 0;
+    const float* height = nullptr;
+    const uint8_t* moisture = nullptr;
+    const VegetationType* vegetation = nullptr;
+};
+
+// The spread kernel's rules on one subdomain plus a one-tile halo of its neighbors' tiles. Random draws are keyed by the global tile index,
+// so the subdomains together make exactly the draws of a single SpreadKernel (and FireSpreadSimulation) with the same seed.
+//
+// Fire spreading into the halo is not decided here: the ignition is sent to the owner of the tile, which applies it unless the tile already
+// burns. Ignitions of the subdomain's own border tiles are sent to the neighbors so their halo stays current, a halo tile that is a step out
+// of date only causes an ignition message its owner ignores.
+class SubdomainKernel {
+    using Rules = SpreadKernel<MooreNeighborhood, DirectionalWind, StepSlope, CounterRng, CompactState>;
+    static constexpr int Count = MooreNeighborhood::Count;
+
+    Subdomain domain_;
+    int worldWidth_;
+    int worldDepth_;
+    int width_; // Owned tiles along each axis
+    int depth_;
+    int haloDepth_; // Tiles per row including the halo
+
+    // Planes over the subdomain and its halo, local index (x - fromX + 1) * haloDepth + (y - fromY + 1)
+    std::vector<float> height_;
+    std::vector<uint8_t> moisture_;
+    std::vector<VegetationType> vegetation_;
+    std::vector<TileState> states_;
+    std::vector<uint16_t> burningFor_;
+    std::vector<int32_t> ignitionTimes_;
+
+    CounterRng rng_;
+    int time_ = 0;
+    std::vector<float> probabilities_; // Per owned tile and neighbor, for the wind below
+    float tableWindSpeed_ = -1.0f;
+    int tableWindDirection_ = -1;
+
+    std::vector<uint32_t> burning_; // Local indices of the owned burning tiles
+    std::vector<uint32_t> nextBurning_;
+    std::vector<uint32_t> outbox_; // Global indices of the ignitions to send after the step
+    std::vector<uint32_t> announcements_; // Border tiles ignited by messages, sent with the next step's outbox
+
+public:
+    SubdomainKernel(const TerrainView& terrain, Subdomain domain, uint32_t seed)
+            : domain_(domain), worldWidth_(terrain.width), worldDepth_(terrain.depth), width_(domain.toX - domain.fromX),
+              depth_(domain.toY - domain.fromY), haloDepth_(depth_ + 2), rng_(seed) {
+        std::size_t localTiles = static_cast<std::size_t>(width_ + 2) * haloDepth_;
+        height_.assign(localTiles, 0.0f);
+        moisture_.assign(localTiles, 100);
+        vegetation_.assign(localTiles, VegetationType::Grass);
+        states_.assign(localTiles, TileState::Unburned);
+        burningFor_.assign(localTiles, 0);
+        ignitionTimes_.assign(localTiles, -1);
+
+        for (int x = std::max(0, domain_.fromX - 1); x < std::min(worldWidth_, domain_.toX + 1); ++x) {
+            for (int y = std::max(0, domain_.fromY - 1); y < std::min(worldDepth_, domain_.toY + 1); ++y) {
+                std::size_t global = static_cast<std::size_t>(x) * worldDepth_ + y;
+                std::size_t local = LocalIndex(x, y);
+                height_[local] = terrain.height[global];
+                moisture_[local] = terrain.moisture[global];
+                vegetation_[local] = terrain.vegetation[global];
+            }
+        }
+    }
+
+    // Sets the given tiles (global indices) burning at time 0. Tiles of other subdomains only update the halo.
+    void Ignite(const std::vector<uint32_t>& tiles) {
+        for (auto tile : tiles) {
+            Receive(tile);
+        }
+    }
+
+    // Advances by one step under the given wind and collects the ignitions to send to the neighbors.
+    void Step(float windSpeed, int windDirection) {
+        time_++;
+        rng_.Advance();
+        nextBurning_.clear();
+        outbox_.swap(announcements_);
+        announcements_.clear();
+        if (probabilities_.empty() || windSpeed != tableWindSpeed_ || windDirection != tableWindDirection_) {
+            BuildProbabilities(windSpeed, windDirection);
+        }
+
+        for (uint32_t tile : burning_) {
+            const int x = static_cast<int>(tile) / haloDepth_ - 1 + domain_.fromX;
+            const int y = static_cast<int>(tile) % haloDepth_ - 1 + domain_.fromY;
+            const uint32_t global = static_cast<uint32_t>(x * worldDepth_ + y);
+            const float* probabilities = &probabilities_[OwnedIndex(x, y) * Count];
+            for (int k = 0; k < Count; ++k) {
+                const int nx = x + MooreNeighborhood::DeltaX[k];
+                const int ny = y + MooreNeighborhood::DeltaY[k];
+                if (nx < 0 || nx >= worldWidth_ || ny < 0 || ny >= worldDepth_) {
+                    continue;
+                }
+                const std::size_t neighbor = LocalIndex(nx, ny);
+                if (states_[neighbor] == TileState::Unburned && rng_.Uniform(global * Count + k) < probabilities[k]) {
+                    states_[neighbor] = TileState::Burning;
+                    ignitionTimes_[neighbor] = time_;
+                    if (domain_.Contains(nx, ny)) {
+                        nextBurning_.push_back(static_cast<uint32_t>(neighbor));
+                        if (IsBorder(nx, ny)) {
+                            outbox_.push_back(static_cast<uint32_t>(nx * worldDepth_ + ny));
+                        }
+                    } else {
+                        outbox_.push_back(static_cast<uint32_t>(nx * worldDepth_ + ny)); // Halo tile, the owner decides
+                    }
+                }
+            }
+
+            if (++burningFor_[tile] >= Rules::GetBurnTime(vegetation_[tile])) {
+                states_[tile] = TileState::Burned;
+            } else {
+                nextBurning_.push_back(tile);
+            }
+        }
+        std::swap(burning_, nextBurning_);
+    }
+
+    // Applies an ignition message of a neighbor (global index) for the current step. Messages for tiles outside the subdomain and its halo
+    // are ignored, so every worker can read all outboxes.
+    void Receive(uint32_t tile) {
+        int x = static_cast<int>(tile) / worldDepth_;
+        int y = static_cast<int>(tile) % worldDepth_;
+        if (x < domain_.fromX - 1 || x > domain_.toX || y < domain_.fromY - 1 || y > domain_.toY) {
+            return;
+        }
+        std::size_t local = LocalIndex(x, y);
+        if (states_[local] != TileState::Unburned) {
+            return;
+        }
+        states_[local] = TileState::Burning;
+        ignitionTimes_[local] = time_;
+        if (domain_.Contains(x, y)) {
+            burning_.push_back(static_cast<uint32_t>(local));
+            if (IsBorder(x, y)) {
+                announcements_.push_back(tile);
+            }
+        }
+    }
+
+    const std::vector<uint32_t>& GetOutbox() const {
+        return outbox_;
+    }
+
+    std::size_t GetBurningCount() const {
+        return burning_.size();
+    }
+
+    // Writes the state of the owned tiles into world-sized planes, in the format of the world's parameters.
+    void WriteState(uint8_t* isBurning, uint8_t* hasBurned, int32_t* burningFor, int32_t* ignitionTimes) const {
+        for (int x = domain_.fromX; x < domain_.toX; ++x) {
+            for (int y = domain_.fromY; y < domain_.toY; ++y) {
+                std::size_t global = static_cast<std::size_t>(x) * worldDepth_ + y;
+                std::size_t local = LocalIndex(x, y);
+                isBurning[global] = states_[local] == TileState::Burning;
+                hasBurned[global] = states_[local] == TileState::Burned;
+                burningFor[global] = burningFor_[local];
+                ignitionTimes[global] = ignitionTimes_[local];
+            }
+        }
+    }
+
+private:
+    std::size_t LocalIndex(int x, int y) const {
+        return static_cast<std::size_t>(x - domain_.fromX + 1) * haloDepth_ + (y - domain_.fromY + 1);
+    }
+
+    std::size_t OwnedIndex(int x, int y) const {
+        return static_cast<std::size_t>(x - domain_.fromX) * depth_ + (y - domain_.fromY);
+    }
+
+    bool IsBorder(int x, int y) const {
+        return x == domain_.fromX || x == domain_.toX - 1 || y == domain_.fromY || y == domain_.toY - 1;
+    }
+
+    // Same table as SpreadKernel::BuildProbabilities, for the owned tiles only.
+    void BuildProbabilities(float windSpeed, int windDirection) {
+        tableWindSpeed_ = windSpeed;
+        tableWindDirection_ = windDirection;
+
+        float windFactors[Count];
+        for (int k = 0; k < Count; ++k) {
+            windFactors[k] = DirectionalWind::Factor(windSpeed, windDirection, MooreNeighborhood::DeltaX[k], MooreNeighborhood::DeltaY[k]);
+        }
+
+        probabilities_.assign(static_cast<std::size_t>(width_) * depth_ * Count, 0.0f);
+        for (int x = domain_.fromX; x < domain_.toX; ++x) {
+            for (int y = domain_.fromY; y < domain_.toY; ++y) {
+                std::size_t tile = LocalIndex(x, y);
+                float inverseBurnTime = 1.0f / Rules::GetBurnTime(vegetation_[tile]);
+                for (int k = 0; k < Count; ++k) {
+                    const int nx = x + MooreNeighborhood::DeltaX[k];
+                    const int ny = y + MooreNeighborhood::DeltaY[k];
+                    if (nx < 0 || nx >= worldWidth_ || ny < 0 || ny >= worldDepth_) {
+                        continue;
+                    }
+                    std::size_t neighbor = LocalIndex(nx, ny);
+                    probabilities_[OwnedIndex(x, y) * Count + k] =
+                            Rules::GetSpreadProbability(inverseBurnTime, height_[tile], vegetation_[neighbor], height_[neighbor], moisture_[neighbor],
+                                                        windFactors[k]);
+                }
+            }
+        }
+    }
+};
+
+
+
+// Shared memory segment (POSIX shm) mapped into this process and inherited by forked workers. The name is unlinked right after mapping,
+// so the segment disappears with the last process using it even if a worker crashes.
+class SharedMemory {
+    void* data_ = nullptr;
+    std::size_t size_ = 0;
+
+public:
+    explicit SharedMemory(std::size_t size) : size_(size) {
+        static std::atomic<int> counter{0};
+        std::string name = "/fireSimulator-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+        int descriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (descriptor < 0) {
+            throw std::system_error(errno, std::generic_category(), "Cannot create shared memory " + name);
+        }
+        if (ftruncate(descriptor, static_cast<off_t>(size_)) != 0) {
+            int error = errno;
+            close(descriptor);
+            shm_unlink(name.c_str());
+            throw std::system_error(error, std::generic_category(), "Cannot size shared memory " + name);
+        }
+        data_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        int error = errno;
+        close(descriptor);
+        shm_unlink(name.c_str());
+        if (data_ == MAP_FAILED) {
+            data_ = nullptr;
+            throw std::system_error(error, std::generic_category(), "Cannot map shared memory " + name);
+        }
+    }
+
+    ~SharedMemory() {
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+    }
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    template <typename T>
+    T* At(std::size_t offset) const {
+        return reinterpret_cast<T*>(static_cast<char*>(data_) + offset);
+    }
+};
+
+// Merged state of a distributed run, in the format of the world's "isBurning", "hasBurned", "burningFor" and "ignitionTime" parameters.
+struct DistributedResult {
+    int steps = 0;
+    std::vector<uint8_t> isBurning;
+    std::vector<uint8_t> hasBurned;
+    std::vector<int32_t> burningFor;
+    std::vector<int32_t> ignitionTimes;
+};
+
+// Runs the fire spread rules of FireSpreadSimulation (without weather, spotting, suppression or drying) in several worker processes, one per
+// subdomain, so no process holds the simulation state of the whole world. The terrain and the merged result live in a shared memory segment
+// next to one outbox of ignition messages per worker. Every step, the workers update their subdomain, publish their outbox, wait for each
+// other at a process-shared barrier, apply the messages of all outboxes and publish how many tiles they have burning; the run ends when no
+// worker has any. The result matches a single-process run with the same seed tile for tile.
+class DistributedSimulation {
+    static constexpr std::size_t Alignment = 64;
+
+    struct Control {
+        pthread_barrier_t barrier;
+        int32_t steps;
+    };
+
+    struct Mailbox {
+        uint64_t burningCount;
+        uint64_t messageCount;
+        // Followed by the messages
+    };
+
+    int width_;
+    int depth_;
+    std::size_t totalTiles_;
+    std::vector<Subdomain> subdomains_;
+    uint32_t seed_;
+
+    std::unique_ptr<SharedMemory> memory_;
+    std::size_t heightOffset_, moistureOffset_, vegetationOffset_;
+    std::size_t isBurningOffset_, hasBurnedOffset_, burningForOffset_, ignitionTimesOffset_;
+    std::vector<std::size_t> mailboxOffsets_;
+
+public:
+    // Copies the terrain into shared memory, after which the world is no longer needed.
+    DistributedSimulation(const TerrainPlanes& terrain, int workers, uint32_t seed)
+            : width_(terrain.width), depth_(terrain.depth), totalTiles_(terrain.Size()),
+              subdomains_(Subdomain::Decompose(terrain.width, terrain.depth, workers)), seed_(seed) {
+        std::size_t size = Align(sizeof(Control));
+        auto reserve = [&size](std::size_t bytes) {
+            std::size_t offset = size;
+            size += Align(bytes);
+            return offset;
+        };
+        heightOffset_ = reserve(totalTiles_ * sizeof(float));
+        moistureOffset_ = reserve(totalTiles_ * sizeof(uint8_t));
+        vegetationOffset_ = reserve(totalTiles_ * sizeof(VegetationType));
+        isBurningOffset_ = reserve(totalTiles_ * sizeof(uint8_t));
+        hasBurnedOffset_ = reserve(totalTiles_ * sizeof(uint8_t));
+        burningForOffset_ = reserve(totalTiles_ * sizeof(int32_t));
+        ignitionTimesOffset_ = reserve(totalTiles_ * sizeof(int32_t));
+        for (const auto& subdomain : subdomains_) {
+            mailboxOffsets_.push_back(reserve(sizeof(Mailbox) + subdomain.GetMessageCapacity() * sizeof(uint32_t)));
+        }
+
+        memory_ = std::make_unique<SharedMemory>(size);
+        std::copy(terrain.height.begin(), terrain.height.end(), memory_->At<float>(heightOffset_));
+        std::copy(terrain.moisture.begin(), terrain.moisture.end(), memory_->At<uint8_t>(moistureOffset_));
+        std::copy(terrain.vegetation.begin(), terrain.vegetation.end(), memory_->At<VegetationType>(vegetationOffset_));
+    }
+
+    const std::vector<Subdomain>& GetSubdomains() const {
+        return subdomains_;
+    }
+
+    // Runs from the ignition tiles (global indices) until the fire is out or maxSteps steps passed. wind(step) returns the wind speed and
+    // direction of the update producing that step. Throws if a worker fails, after stopping the others.
+    DistributedResult Run(const std::vector<uint32_t>& ignitions, const std::function<std::pair<float, int>(int)>& wind, int maxSteps) {
+        Control* control = memory_->At<Control>(0);
+        pthread_barrierattr_t attributes;
+        pthread_barrierattr_init(&attributes);
+        pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        int error = pthread_barrier_init(&control->barrier, &attributes, static_cast<unsigned>(subdomains_.size()));
+        pthread_barrierattr_destroy(&attributes);
+        if (error != 0) {
+            throw std::system_error(error, std::generic_category(), "Cannot create worker barrier");
+        }
+        control->steps = 0;
+
+        std::vector<pid_t> workers;
+        for (std::size_t worker = 0; worker < subdomains_.size(); ++worker) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                // Worker process: never returns into the caller's code
+                int status = 0;
+                try {
+                    RunWorker(worker, ignitions, wind, maxSteps);
+                } catch (const std::exception& e) {
+                    std::cerr << "Worker " << worker << ": " << e.what() << std::endl;
+                    status = 1;
+                }
+                _exit(status);
+            }
+            if (pid < 0) {
+                int forkError = errno;
+                StopWorkers(workers);
+                pthread_barrier_destroy(&control->barrier);
+                throw std::system_error(forkError, std::generic_category(), "Cannot start worker process");
+            }
+            workers.push_back(pid);
+        }
+
+        bool failed = false;
+        for (std::size_t remaining = workers.size(); remaining > 0; --remaining) {
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, 0);
+            if (pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                failed = true;
+                StopWorkers(workers); // The others would wait at the barrier forever
+                break;
+            }
+            workers.erase(std::remove(workers.begin(), workers.end(), pid), workers.end());
+        }
+        pthread_barrier_destroy(&control->barrier);
+        if (failed) {
+            throw std::runtime_error("Distributed simulation worker failed");
+        }
+
+        DistributedResult result;
+        result.steps = control->steps;
+        result.isBurning.assign(memory_->At<uint8_t>(isBurningOffset_), memory_->At<uint8_t>(isBurningOffset_) + totalTiles_);
+        result.hasBurned.assign(memory_->At<uint8_t>(hasBurnedOffset_), memory_->At<uint8_t>(hasBurnedOffset_) + totalTiles_);
+        result.burningFor.assign(memory_->At<int32_t>(burningForOffset_), memory_->At<int32_t>(burningForOffset_) + totalTiles_);
+        result.ignitionTimes.assign(memory_->At<int32_t>(ignitionTimesOffset_), memory_->At<int32_t>(ignitionTimesOffset_) + totalTiles_);
+        return result;
+    }
+
+private:
+    static std::size_t Align(std::size_t bytes) {
+        return (bytes + Alignment - 1) / Alignment * Alignment;
+    }
+
+    static void StopWorkers(const std::vector<pid_t>& workers) {
+        for (pid_t pid : workers) {
+            kill(pid, SIGKILL);
+        }
+        for (pid_t pid : workers) {
+            waitpid(pid, nullptr, 0);
+        }
+    }
+
+    void RunWorker(std::size_t worker, const std::vector<uint32_t>& ignitions, const std::function<std::pair<float, int>(int)>& wind, int maxSteps) {
+        Control* control = memory_->At<Control>(0);
+        TerrainView terrain{width_, depth_, memory_->At<float>(heightOffset_), memory_->At<uint8_t>(moistureOffset_),
+                            memory_->At<VegetationType>(vegetationOffset_)};
+        SubdomainKernel kernel(terrain, subdomains_[worker], seed_);
+        Mailbox* mailbox = memory_->At<Mailbox>(mailboxOffsets_[worker]);
+
+        kernel.Ignite(ignitions);
+        mailbox->burningCount = kernel.GetBurningCount();
+        pthread_barrier_wait(&control->barrier);
+
+        int steps = 0;
+        while (steps < maxSteps && TotalBurning() > 0) {
+            auto [windSpeed, windDirection] = wind(steps + 1);
+            kernel.Step(windSpeed, windDirection);
+            const auto& outbox = kernel.GetOutbox();
+            if (outbox.size() > subdomains_[worker].GetMessageCapacity()) {
+                throw std::logic_error("Outbox of a worker overflowed");
+            }
+            mailbox->messageCount = outbox.size();
+            std::copy(outbox.begin(), outbox.end(), reinterpret_cast<uint32_t*>(mailbox + 1));
+            pthread_barrier_wait(&control->barrier);
+
+            for (std::size_t other = 0; other < subdomains_.size(); ++other) {
+                if (other == worker) {
+                    continue;
+                }
+                const Mailbox* otherMailbox = memory_->At<Mailbox>(mailboxOffsets_[other]);
+                const uint32_t* messages = reinterpret_cast<const uint32_t*>(otherMailbox + 1);
+                for (uint64_t i = 0; i < otherMailbox->messageCount; ++i) {
+                    kernel.Receive(messages[i]);
+                }
+            }
+            mailbox->burningCount = kernel.GetBurningCount();
+            pthread_barrier_wait(&control->barrier);
+            steps++;
+        }
+
+        kernel.WriteState(memory_->At<uint8_t>(isBurningOffset_), memory_->At<uint8_t>(hasBurnedOffset_),
+                          memory_->At<int32_t>(burningForOffset_), memory_->At<int32_t>(ignitionTimesOffset_));
+        if (worker == 0) {
+            control->steps = steps;
+        }
+    }
+
+    uint64_t TotalBurning() const {
+        uint64_t total = 0;
+        for (auto offset : mailboxOffsets_) {
+            total += memory_->At<Mailbox>(offset)->burningCount;
+        }
+        return total;
+    }
+};
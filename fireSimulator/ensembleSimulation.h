@@ -0,0 +1,518 @@
+#pragma once
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+
+#include "policySimulation.h"
+#include "simd.h"
+#include "taskScheduler.h"
+
+// Realizations of the rules of SpreadKernel (Moore neighborhood, directional wind, step slope) run side by side, bit-sliced: each tile keeps
+// the realizations the fire reached it in as Words 64-bit words, one bit (lane) per realization, so 64 * Words realizations spread at once
+// and the number of realizations that reached a tile is a popcount.
+//
+// Under a constant wind, the tiles a SpreadKernel run burns before the fire goes out are exactly the tiles reachable from the ignitions over
+// open edges, an edge from a tile to a neighbor being open with the total spread chance over the source's burn time (the per-step chance
+// compounded over the burn time, the reverse of GetStepProbability). So the ensemble draws every edge once per lane, bit-sliced: the chance
+// of the edge is a 16-bit threshold, and the 16-bit uniform numbers of all lanes are compared with it bit by bit from the most significant
+// one, a random word per bit for the first bits and then lane by lane for the few lanes left (about 5 random words per 64 lanes, see
+// DrawEdges). The edges are drawn a lane word at a time, when the fire first reaches the tile in one of the word's lanes, so small fires do
+// not pay for the lanes they never reach.
+//
+// Spreading is then plain bitwise propagation, lanes reached at a tile AND the open lanes of an edge OR into the neighbor, repeated until
+// nothing changes. Stepping the lanes in time would not share much work: the realizations soon drift apart and a tile only burns in a few
+// of them at once. Tiles with newly reached lanes are marked in a bitmap instead, which is swept in alternating directions, band by band
+// (see SpreadTiles); a tile spreads all lanes that reached it since its last visit together. Realizations follow the distribution of
+// independent SpreadKernel runs to their end but are not identical to any of them, the draws differ.
+//
+// A tile is visited once per sweep that brings it new lanes, dozens of times in large fires, so a visit has to be cheap: lane state is kept
+// in pages of 64 consecutive tiles, the neighbors of a tile are at most three rows apart in them, and with 256 lanes a visit is a few AVX2
+// instructions per neighbor the fire reaches. Pages are only allocated where the fire reached some realization, so memory and the cost of
+// starting over scale with the burned area rather than with the world.
+//
+// Limits:
+// - Edge chances are quantized to 16 bits, i.e. rounded to multiples of 1/65536. Chances below 1/131072 never open and no edge is open
+//   with certainty (at most 65535/65536), unlike in SpreadKernel, which compares with 32-bit thresholds.
+// - The wind is constant for a whole run, since every edge is drawn once for the run. SetWind throws while a fire spreads, i.e. between
+//   Ignite and the end of Spread, instead of drawing the edges of tiles reached later under another wind.
+// - The cost grows with the area burned in any realization of a batch, not with the mean burned area, so a batch in which few fires escape
+//   gains less over separate SpreadKernel runs than one in which most of them burn large areas (see fireBurnProbability --compare). On one
+//   core with AVX2, realizations are about 9-13x faster than SpreadKernel runs where most fires spread far under wind, 2-3x where few do.
+template <int Words>
+class BitSlicedEnsemble {
+    using Rules = SpreadKernel<MooreNeighborhood, DirectionalWind, StepSlope, CounterRng, CompactState>;
+    static constexpr int ThresholdBits = 16;
+    static constexpr int WordSteps = 4; // Threshold bits compared a lane word at a time, see DrawEdges
+    static constexpr int Neighbors = MooreNeighborhood::Count;
+    static constexpr uint32_t PageTiles = 64; // Tiles per page, one word of the spreading bitmap
+    static constexpr std::size_t BandBytes = 1 << 20; // Lane state swept to a standstill at a time, so that it stays in L2
+
+    // Lanes of a tile, read for every spread into it.
+    struct TileLanes {
+        uint64_t reached[Words];
+        uint64_t spreading[Words]; // Reached since the tile's last visit
+    };
+
+    // Out-edges of a tile, only read when the tile itself spreads. A word is drawn when the tile's reached word becomes nonzero.
+    struct TileEdges {
+        uint64_t open[Neighbors][Words]; // Lanes in which the edge to each neighbor is open
+    };
+
+    // Lane state of PageTiles consecutive tiles.
+    struct Page {
+        TileLanes lanes[PageTiles];
+        TileEdges edges[PageTiles];
+    };
+
+    TerrainPlanes terrain_;
+    CounterRandom random_;
+    int sweeps_ = 0;
+    std::ptrdiff_t neighborOffsets_[Neighbors]; // Tile index differences to the neighbors
+
+    std::vector<uint16_t> thresholds_; // Per tile and neighbor, for the wind below, 0 for edges leaving the world
+    float tableWindSpeed_ = -1.0f;
+    int tableWindDirection_ = -1;
+
+    std::vector<Page*> pageTable_; // Per page of the world (tile / PageTiles), the page holding it or null
+    std::vector<std::unique_ptr<Page>> pages_; // The first usedPages_ are in use, the others are kept for the next run
+    std::vector<uint32_t> pageOwners_; // Page of the world each page in use holds
+    std::size_t usedPages_ = 0;
+    std::vector<uint64_t> spreading_; // Bitmap of the tiles with spreading lanes
+    std::size_t spreadingCount_ = 0;
+
+public:
+    static constexpr int Realizations = 64 * Words;
+
+    BitSlicedEnsemble(TerrainPlanes terrain, uint32_t seed)
+            : terrain_(std::move(terrain)), random_(seed), pageTable_((terrain_.Size() + PageTiles - 1) / PageTiles, nullptr),
+              spreading_(pageTable_.size(), 0) {
+        for (int k = 0; k < Neighbors; ++k) {
+            neighborOffsets_[k] = static_cast<std::ptrdiff_t>(MooreNeighborhood::DeltaX[k]) * terrain_.depth + MooreNeighborhood::DeltaY[k];
+        }
+    }
+
+    // Restarts the random draws from a new seed. The threshold table is kept, so batches on the same terrain skip rebuilding it.
+    void Reseed(uint32_t seed) {
+        random_ = CounterRandom(seed);
+    }
+
+    // Sets the wind of the realizations, the threshold table is rebuilt if it changed. The wind cannot change while a fire spreads.
+    void SetWind(float windSpeed, int windDirection) {
+        if (thresholds_.empty() || windSpeed != tableWindSpeed_ || windDirection != tableWindDirection_) {
+            if (spreadingCount_ > 0) {
+                throw std::logic_error("The wind of a bit-sliced ensemble is constant, it cannot change between Ignite and the end of Spread");
+            }
+            BuildThresholds(windSpeed, windDirection);
+        }
+    }
+
+    // Clears all lanes and lets the fire reach the given tiles in the first realizations lanes. Requires the wind to be set.
+    void Ignite(const std::vector<uint32_t>& tiles, int realizations = Realizations) {
+        if (realizations < 1 || realizations > Realizations) {
+            throw std::invalid_argument("A bit-sliced ensemble runs 1 to " + std::to_string(Realizations) + " realizations");
+        }
+        if (thresholds_.empty()) {
+            throw std::logic_error("The wind of the ensemble is not set");
+        }
+        for (std::size_t slot = 0; slot < usedPages_; ++slot) {
+            pageTable_[pageOwners_[slot]] = nullptr;
+            spreading_[pageOwners_[slot]] = 0;
+        }
+        usedPages_ = 0;
+        pageOwners_.clear();
+        spreadingCount_ = 0;
+        sweeps_ = 0;
+
+        uint64_t lanes[Words];
+        unsigned words = 0;
+        for (int word = 0; word < Words; ++word) {
+            int count = std::clamp(realizations - word * 64, 0, 64);
+            lanes[word] = count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+            words |= static_cast<unsigned>(lanes[word] != 0) << word;
+        }
+        for (auto tile : tiles) {
+            if (tile >= terrain_.Size()) {
+                throw std::out_of_range("Ignition tile outside the world");
+            }
+            Page& page = GetPage(tile);
+            TileLanes& target = page.lanes[tile % PageTiles];
+            if (target.reached[0] != 0) {
+                continue;
+            }
+            for (int word = 0; word < Words; ++word) {
+                target.reached[word] = lanes[word];
+                target.spreading[word] = lanes[word];
+            }
+            DrawEdges(tile, page.edges[tile % PageTiles], words);
+            MarkSpreading(tile);
+        }
+    }
+
+    // Spreads the fire in all realizations until it is out everywhere.
+    void Spread() {
+#if FIRESIM_X86_SIMD
+        if (Words % 4 == 0 && CpuFeatures::HasAvx2()) {
+            SpreadAvx2();
+            return;
+        }
+#endif
+        SpreadTiles<false>();
+    }
+
+    // Sweeps the last Spread took.
+    int GetSweeps() const {
+        return sweeps_;
+    }
+
+    // Whether the fire reached the tile in the realization.
+    bool IsReached(uint32_t tile, int realization) const {
+        const Page* page = pageTable_.at(tile / PageTiles);
+        return page != nullptr && (page->lanes[tile % PageTiles].reached[realization / 64] >> (realization % 64) & 1);
+    }
+
+    // Adds the number of realizations that reached each tile to counts (one per tile).
+    void AddReachedCounts(std::vector<uint32_t>& counts) const {
+        for (std::size_t slot = 0; slot < usedPages_; ++slot) {
+            const Page& page = *pages_[slot];
+            std::size_t firstTile = static_cast<std::size_t>(pageOwners_[slot]) * PageTiles;
+            std::size_t tiles = std::min<std::size_t>(PageTiles, counts.size() - firstTile);
+            for (std::size_t tile = 0; tile < tiles; ++tile) {
+                for (int word = 0; word < Words; ++word) {
+                    counts[firstTile + tile] += static_cast<uint32_t>(__builtin_popcountll(page.lanes[tile].reached[word]));
+                }
+            }
+        }
+    }
+
+private:
+    // Page holding the tile, allocated (cleared) when the fire first reaches one of its tiles.
+    FIRESIM_INLINE Page& GetPage(uint32_t tile) {
+        Page*& page = pageTable_[tile / PageTiles];
+        if (__builtin_expect(page == nullptr, 0)) {
+            page = AllocatePage(tile / PageTiles);
+        }
+        return *page;
+    }
+
+    Page* AllocatePage(uint32_t owner) {
+        if (usedPages_ == pages_.size()) {
+            pages_.push_back(std::make_unique<Page>());
+        }
+        std::memset(pages_[usedPages_].get(), 0, sizeof(Page));
+        pageOwners_.push_back(owner);
+        return pages_[usedPages_++].get();
+    }
+
+    // Marks the tile spreading if marked is true, without a branch: whether a neighbor gained lanes is hard to predict.
+    FIRESIM_INLINE void MarkSpreading(uint32_t tile, bool marked = true) {
+        uint64_t bit = static_cast<uint64_t>(marked) << (tile % 64);
+        spreadingCount_ += (bit & ~spreading_[tile / 64]) != 0;
+        spreading_[tile / 64] |= bit;
+    }
+
+    // Chance of every edge as a threshold of 16-bit uniform numbers.
+    void BuildThresholds(float windSpeed, int windDirection) {
+        tableWindSpeed_ = windSpeed;
+        tableWindDirection_ = windDirection;
+
+        float windFactors[Neighbors];
+        for (int k = 0; k < Neighbors; ++k) {
+            windFactors[k] = DirectionalWind::Factor(windSpeed, windDirection, MooreNeighborhood::DeltaX[k], MooreNeighborhood::DeltaY[k]);
+        }
+
+        const int width = terrain_.width;
+        const int depth = terrain_.depth;
+        thresholds_.assign(terrain_.Size() * Neighbors, 0);
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < depth; ++y) {
+                std::size_t tile = static_cast<std::size_t>(x) * depth + y;
+                for (int k = 0; k < Neighbors; ++k) {
+                    const int nx = x + MooreNeighborhood::DeltaX[k];
+                    const int ny = y + MooreNeighborhood::DeltaY[k];
+                    if (nx < 0 || nx >= width || ny < 0 || ny >= depth) {
+                        continue;
+                    }
+                    std::size_t neighbor = static_cast<std::size_t>(nx) * depth + ny;
+                    // A burn time of one step makes the per-step chance the total one
+                    float probability = Rules::GetSpreadProbability(1.0f, terrain_.height[tile], terrain_.vegetation[neighbor], terrain_.height[neighbor],
+                                                                    terrain_.moisture[neighbor], windFactors[k]);
+                    long threshold = std::lround(probability * (1 << ThresholdBits));
+                    thresholds_[tile * Neighbors + k] = static_cast<uint16_t>(std::clamp(threshold, 0L, (1L << ThresholdBits) - 1));
+                }
+            }
+        }
+    }
+
+    // Random word number index of the draws keyed by key.
+    static uint64_t RandomWord(uint64_t key, uint64_t index) {
+        uint64_t z = key + (index + 1) * 0x9e3779b97f4a7c15ull; // SplitMix64
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // Draws the given lane words (a bit per word) of the tile's out-edges: a lane is open when its uniform draw for the edge is below the
+    // threshold. The first WordSteps bits are compared for all lanes at once, a random word per bit. The few lanes still equal to the
+    // threshold then take their remaining bits one lane at a time from a shared random word, each only up to its first bit that differs
+    // from the threshold, which decides it, so about 5 random words decide 64 lanes instead of 7. The bits are consumed in a fixed order,
+    // so a lane's draw only depends on the edge and its word, not on when the word is drawn.
+    void DrawEdges(uint32_t tile, TileEdges& edges, unsigned words) const {
+        constexpr int LaneBits = ThresholdBits - WordSteps;
+        const uint16_t* thresholds = thresholds_.data() + static_cast<std::size_t>(tile) * Neighbors;
+        for (int k = 0; k < Neighbors; ++k) {
+            if (thresholds[k] == 0) {
+                continue; // Also every edge leaving the world
+            }
+            uint32_t slot = tile * Neighbors + k;
+            uint64_t key = uint64_t(random_.Bits(slot)) << 32 | slot;
+            const unsigned laneThreshold = thresholds[k] & ((1u << LaneBits) - 1);
+            for (int word = 0; word < Words; ++word) {
+                if (!(words >> word & 1)) {
+                    continue;
+                }
+                uint64_t equal = ~uint64_t(0);
+                uint64_t below = 0;
+                uint64_t index = static_cast<uint64_t>(word);
+                for (int bit = ThresholdBits - 1; bit >= LaneBits; --bit, index += Words) {
+                    uint64_t random = RandomWord(key, index);
+                    if (thresholds[k] >> bit & 1) {
+                        below |= equal & ~random;
+                        equal &= random;
+                    } else {
+                        equal &= ~random;
+                    }
+                }
+
+                uint64_t random = 0;
+                int available = 0; // Unused bits at the top of random
+                for (; equal != 0; equal &= equal - 1) {
+                    if (available < LaneBits) {
+                        random = RandomWord(key, index);
+                        index += Words;
+                        available = 64;
+                    }
+                    unsigned draw = static_cast<unsigned>(random >> (64 - LaneBits));
+                    unsigned differing = draw ^ laneThreshold;
+                    int used = differing == 0 ? LaneBits : __builtin_clz(differing) - (31 - LaneBits);
+                    below |= static_cast<uint64_t>(draw < laneThreshold) << __builtin_ctzll(equal);
+                    random <<= used;
+                    available -= used;
+                }
+                edges.open[k][word] = below;
+            }
+        }
+    }
+
+    // Spreads the lanes that reached a tile since its last visit over its open edges into the lanes its neighbors were not reached in yet.
+    FIRESIM_INLINE void SpreadTile(uint32_t tile) {
+        Page& page = *pageTable_[tile / PageTiles];
+        TileLanes& lanes = page.lanes[tile % PageTiles];
+        const TileEdges& edges = page.edges[tile % PageTiles];
+        uint64_t spreading[Words];
+        for (int word = 0; word < Words; ++word) {
+            spreading[word] = lanes.spreading[word];
+            lanes.spreading[word] = 0;
+        }
+        for (int k = 0; k < Neighbors; ++k) {
+            uint64_t hits[Words];
+            uint64_t any = 0;
+            for (int word = 0; word < Words; ++word) {
+                hits[word] = spreading[word] & edges.open[k][word];
+                any |= hits[word];
+            }
+            if (any == 0) {
+                continue; // Also every edge leaving the world or into water
+            }
+
+            const uint32_t neighbor = static_cast<uint32_t>(tile + neighborOffsets_[k]);
+            Page& targetPage = GetPage(neighbor);
+            TileLanes& target = targetPage.lanes[neighbor % PageTiles];
+            unsigned newWords = 0;
+            any = 0;
+            for (int word = 0; word < Words; ++word) {
+                hits[word] &= ~target.reached[word];
+                newWords |= static_cast<unsigned>(target.reached[word] == 0 && hits[word] != 0) << word;
+                target.reached[word] |= hits[word];
+                target.spreading[word] |= hits[word];
+                any |= hits[word];
+            }
+            if (__builtin_expect(newWords != 0, 0)) {
+                DrawEdges(neighbor, targetPage.edges[neighbor % PageTiles], newWords);
+            }
+            MarkSpreading(neighbor, any != 0);
+        }
+    }
+
+    // Sweeps the bitmap of spreading tiles in bands of BandBytes of lane state, ascending and descending by turns. Each band is swept
+    // until none of its tiles spreads, then the next, and the bands are passed over in alternating order until no tile is left: most
+    // lanes travel far within a band, so sweeping the whole world every time would reload its lane state from memory for a few of them.
+    template <bool Avx2>
+    FIRESIM_INLINE void SpreadTiles() {
+        sweeps_ = 0;
+        const std::size_t words = spreading_.size();
+        const std::size_t bandWords = std::max<std::size_t>(1, BandBytes / (PageTiles * (sizeof(TileLanes) + sizeof(TileEdges))));
+        const std::size_t bands = (words + bandWords - 1) / bandWords;
+        for (int pass = 0; spreadingCount_ > 0; ++pass) {
+            for (std::size_t b = 0; b < bands; ++b) {
+                const std::size_t first = (pass % 2 == 0 ? b : bands - 1 - b) * bandWords;
+                const std::size_t count = std::min(bandWords, words - first);
+                for (bool processed = true; processed; sweeps_ += processed) {
+                    processed = false;
+                    bool ascending = sweeps_ % 2 == 0;
+                    for (std::size_t i = 0; i < count; ++i) {
+                        std::size_t word = first + (ascending ? i : count - 1 - i);
+                        while (spreading_[word] != 0) {
+                            int bit = ascending ? __builtin_ctzll(spreading_[word]) : 63 - __builtin_clzll(spreading_[word]);
+                            spreading_[word] &= ~(uint64_t(1) << bit);
+                            spreadingCount_--;
+                            processed = true;
+#if FIRESIM_X86_SIMD
+                            if constexpr (Avx2) {
+                                SpreadTileAvx2(static_cast<uint32_t>(word * 64 + bit));
+                                continue;
+                            }
+#endif
+                            SpreadTile(static_cast<uint32_t>(word * 64 + bit));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+#if FIRESIM_X86_SIMD
+    FIRESIM_TARGET_AVX2 void SpreadAvx2() {
+        SpreadTiles<true>();
+    }
+
+    // SpreadTile for Words a multiple of 4, 256 lanes per instruction. The edges with hits are found first and then only those are
+    // followed, which leaves one branch per neighbor the fire actually reaches.
+    FIRESIM_TARGET_AVX2 void SpreadTileAvx2(uint32_t tile) {
+        constexpr int Vectors = Words / 4;
+        Page& page = *pageTable_[tile / PageTiles];
+        TileLanes& lanes = page.lanes[tile % PageTiles];
+        const TileEdges& edges = page.edges[tile % PageTiles];
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i spreading[Vectors];
+        for (int v = 0; v < Vectors; ++v) {
+            spreading[v] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.spreading + 4 * v));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.spreading + 4 * v), zero);
+        }
+        __m256i hits[Neighbors][Vectors];
+        unsigned hitEdges = 0;
+        for (int k = 0; k < Neighbors; ++k) {
+            __m256i any = zero;
+            for (int v = 0; v < Vectors; ++v) {
+                hits[k][v] = _mm256_and_si256(spreading[v], _mm256_loadu_si256(reinterpret_cast<const __m256i*>(edges.open[k] + 4 * v)));
+                any = _mm256_or_si256(any, hits[k][v]);
+            }
+            hitEdges |= static_cast<unsigned>(!_mm256_testz_si256(any, any)) << k;
+        }
+
+        for (; hitEdges != 0; hitEdges &= hitEdges - 1) {
+            const int k = __builtin_ctz(hitEdges);
+            const uint32_t neighbor = static_cast<uint32_t>(tile + neighborOffsets_[k]);
+            Page& targetPage = GetPage(neighbor);
+            TileLanes& target = targetPage.lanes[neighbor % PageTiles];
+            unsigned newWords = 0;
+            __m256i any = zero;
+            for (int v = 0; v < Vectors; ++v) {
+                __m256i* reachedWords = reinterpret_cast<__m256i*>(target.reached + 4 * v);
+                __m256i* spreadingWords = reinterpret_cast<__m256i*>(target.spreading + 4 * v);
+                __m256i reached = _mm256_loadu_si256(reachedWords);
+                __m256i fresh = _mm256_andnot_si256(reached, hits[k][v]);
+                __m256i firstLanes = _mm256_andnot_si256(_mm256_cmpeq_epi64(fresh, zero), _mm256_cmpeq_epi64(reached, zero));
+                newWords |= static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(firstLanes))) << (4 * v);
+                _mm256_storeu_si256(reachedWords, _mm256_or_si256(reached, fresh));
+                _mm256_storeu_si256(spreadingWords, _mm256_or_si256(_mm256_loadu_si256(spreadingWords), fresh));
+                any = _mm256_or_si256(any, fresh);
+            }
+            if (__builtin_expect(newWords != 0, 0)) {
+                DrawEdges(neighbor, targetPage.edges[neighbor % PageTiles], newWords);
+            }
+            MarkSpreading(neighbor, !_mm256_testz_si256(any, any));
+        }
+    }
+#endif
+};
+
+// Share of realizations in which each tile burned.
+struct BurnProbabilityMap {
+    int width = 0;
+    int depth = 0;
+    int realizations = 0;
+    std::vector<float> probability; // Per tile index (x * depth + y)
+
+    // Writes the probabilities as an ESRI ASCII grid, rows being width positions like the raster exporter's.
+    void WriteAsciiGrid(std::ostream& out) const {
+        out << "ncols " << depth << "\nnrows " << width << "\nxllcorner 0\nyllcorner 0\ncellsize 1\nNODATA_value -1\n";
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < depth; ++y) {
+                out << (y == 0 ? "" : " ") << probability[static_cast<std::size_t>(x) * depth + y];
+            }
+            out << '\n';
+        }
+    }
+};
+
+// Monte Carlo burn probability maps from bit-sliced ensembles: the share of SpreadKernel runs under a constant wind, each until its fire
+// is out, that burn each tile. Realizations are run in batches of 256 (64 for small ensembles), batch i with seed + i, spread over the task
+// scheduler. The map only depends on the seed and the number of realizations, not on the threads.
+class BurnProbabilityEnsemble {
+    TerrainPlanes terrain_;
+    TaskScheduler& scheduler_;
+
+public:
+    BurnProbabilityEnsemble(TerrainPlanes terrain, TaskScheduler& scheduler) : terrain_(std::move(terrain)), scheduler_(scheduler) {}
+
+    // Runs the realizations from the ignition tiles (indices x * depth + y).
+    BurnProbabilityMap Run(const std::vector<uint32_t>& ignitions, int realizations, uint32_t seed, float windSpeed, int windDirection) {
+        if (realizations < 1) {
+            throw std::invalid_argument("A burn probability map needs at least one realization");
+        }
+        return realizations <= BitSlicedEnsemble<1>::Realizations ? RunBatches<1>(ignitions, realizations, seed, windSpeed, windDirection)
+                                                                  : RunBatches<4>(ignitions, realizations, seed, windSpeed, windDirection);
+    }
+
+private:
+    template <int Words>
+    BurnProbabilityMap RunBatches(const std::vector<uint32_t>& ignitions, int realizations, uint32_t seed, float windSpeed, int windDirection) {
+        constexpr int BatchSize = BitSlicedEnsemble<Words>::Realizations;
+        std::size_t batches = static_cast<std::size_t>((realizations + BatchSize - 1) / BatchSize);
+        std::size_t parts = std::min(batches, scheduler_.GetThreadCount());
+        std::vector<uint32_t> counts(terrain_.Size(), 0);
+        std::mutex mergeMutex;
+
+        // Every part re-uses one ensemble (and its threshold table) for its share of the batches
+        scheduler_.ParallelFor(0, parts, 1, [&](std::size_t fromPart, std::size_t toPart) {
+            BitSlicedEnsemble<Words> ensemble(terrain_, seed);
+            ensemble.SetWind(windSpeed, windDirection);
+            std::vector<uint32_t> partCounts(terrain_.Size(), 0);
+            for (std::size_t part = fromPart; part < toPart; ++part) {
+                for (std::size_t batch = part; batch < batches; batch += parts) {
+                    ensemble.Reseed(seed + static_cast<uint32_t>(batch));
+                    ensemble.Ignite(ignitions, std::min(BatchSize, realizations - static_cast<int>(batch) * BatchSize));
+                    ensemble.Spread();
+                    ensemble.AddReachedCounts(partCounts);
+                }
+            }
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            for (std::size_t tile = 0; tile < counts.size(); ++tile) {
+                counts[tile] += partCounts[tile];
+            }
+        });
+
+        BurnProbabilityMap map;
+        map.width = terrain_.width;
+        map.depth = terrain_.depth;
+        map.realizations = realizations;
+        map.probability.resize(counts.size());
+        for (std::size_t tile = 0; tile < counts.size(); ++tile) {
+            map.probability[tile] = static_cast<float>(counts[tile]) / static_cast<float>(realizations);
+        }
+        return map;
+    }
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include <array>
+#include <ostream>
+#include <vector>
+
+#include "simulationObserver.h"
+#include "worldClasses.h"
+
+// Aggregates of the fire after one step.
+struct FireStatisticsSample {
+    int step = 0;
+    std::size_t burningTiles = 0;
+    std::size_t burnedTiles = 0;
+    std::size_t perimeter = 0; // Tile edges between tiles the fire reached (burning or burned) and tiles it did not, the world border excluded
+    std::size_t ignitions = 0; // Tiles that caught fire in the step, i.e. the spread rate in tiles per step
+    std::size_t burnouts = 0;
+};
+
+// Fire statistics kept up to date from the changes a simulation publishes (see Simulation::Subscribe), so every step costs time in the
+// number of changed tiles instead of a scan of the whole world. Keeps its own copy of the fire state and the samples of all steps.
+class FireStatistics : public SimulationObserver {
+    static constexpr std::size_t VegetationTypes = 4;
+
+    int width_;
+    int depth_;
+    std::vector<TileState> states_;
+    std::vector<VegetationType> vegetation_;
+    std::array<std::size_t, VegetationTypes> reachedByVegetation_{};
+    FireStatisticsSample current_;
+    std::vector<FireStatisticsSample> history_;
+
+public:
+    explicit FireStatistics(const World& world)
+            : width_(world.GetWidth()), depth_(world.GetDepth()), states_(static_cast<std::size_t>(width_) * depth_, TileState::Unburned),
+              vegetation_(states_.size()) {
+        for (int x = 0; x < width_; ++x) {
+            for (int y = 0; y < depth_; ++y) {
+                vegetation_[static_cast<std::size_t>(x) * depth_ + y] = world.grid[x][y]->GetVegetation();
+            }
+        }
+    }
+
+    // Applies the changes of a step and records its sample. Step 0 (Simulation::Initialize) starts over from an unburned world.
+    void OnStepCompleted(const StepChanges& changes) override {
+        if (changes.step == 0) {
+            Clear();
+        }
+        for (std::size_t i = 0; i < changes.tiles.size(); ++i) {
+            Apply(changes.tiles[i], changes.states[i]);
+        }
+        current_.step = changes.step;
+        current_.ignitions = changes.ignitions.size();
+        current_.burnouts = changes.burnouts.size();
+        history_.push_back(current_);
+    }
+
+    // Sample of the last published step.
+    const FireStatisticsSample& GetCurrent() const {
+        return current_;
+    }
+
+    // Samples of all steps since step 0, in the order they were published.
+    const std::vector<FireStatisticsSample>& GetHistory() const {
+        return history_;
+    }
+
+    // Number of tiles of the vegetation the fire reached (burning or burned).
+    std::size_t GetReachedTiles(VegetationType vegetation) const {
+        return reachedByVegetation_[static_cast<std::size_t>(vegetation)];
+    }
+
+    // Writes the samples as CSV, one line per step.
+    void WriteCsv(std::ostream& out) const {
+        out << "step,burningTiles,burnedTiles,perimeter,ignitions,burnouts\n";
+        for (const auto& sample : history_) {
+            out << sample.step << "," << sample.burningTiles << "," << sample.burnedTiles << "," << sample.perimeter << "," << sample.ignitions
+                << "," << sample.burnouts << "\n";
+        }
+    }
+
+private:
+    void Clear() {
+        std::fill(states_.begin(), states_.end(), TileState::Unburned);
+        reachedByVegetation_.fill(0);
+        current_ = FireStatisticsSample();
+        history_.clear();
+    }
+
+    // Moves the tile to its new state. The perimeter only changes when a tile becomes reached or unreached, by its four edge neighbors.
+    void Apply(uint32_t tileIndex, TileState state) {
+        TileState previous = states_[tileIndex];
+        if (previous == state) {
+            return;
+        }
+        states_[tileIndex] = state;
+        Count(previous, -1);
+        Count(state, 1);
+
+        bool wasReached = previous != TileState::Unburned;
+        bool isReached = state != TileState::Unburned;
+        if (wasReached == isReached) {
+            return;
+        }
+        reachedByVegetation_[static_cast<std::size_t>(vegetation_[tileIndex])] += isReached ? 1 : -1;
+        int x = static_cast<int>(tileIndex / depth_);
+        int y = static_cast<int>(tileIndex % depth_);
+        const int deltas[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        for (const auto& delta : deltas) {
+            int nx = x + delta[0];
+            int ny = y + delta[1];
+            if (nx < 0 || nx >= width_ || ny < 0 || ny >= depth_) {
+                continue;
+            }
+            // An edge to a reached neighbor stops being perimeter when the tile is reached and becomes perimeter when it is unreached
+            bool neighborReached = states_[static_cast<std::size_t>(nx) * depth_ + ny] != TileState::Unburned;
+            current_.perimeter += neighborReached == isReached ? -1 : 1;
+        }
+    }
+
+    void Count(TileState state, int delta) {
+        if (state == TileState::Burning) {
+            current_.burningTiles += delta;
+        } else if (state == TileState::Burned) {
+            current_.burnedTiles += delta;
+        }
+    }
+};
@@ -0,0 +1,386 @@
+#pragma once
+#include <limits>
+
+#include "simulation.h"
+#include "simd.h"
+
+// Cellular automaton with fractional fuel. Every tile stores its remaining fuel load and its fire intensity (0 - 1) as floats instead of
+// the binary burning/burned state. In each step a tile is heated by the intensity of its 8 neighbors, weighted by wind and distance,
+// and burning consumes fuel in proportion to the intensity until the tile burns out.
+//
+// The planes are padded by one border tile, so the stencil needs no bounds checks, and rows are split into chunks of 8 tiles that are
+// updated as one vector. An activity bitmap over the chunks skips every chunk without fire in or next to it, so the cost of a step scales
+// with the burning area instead of the map size.
+class FuelSimulation : public Simulation {
+    static constexpr int ChunkSize = 8;
+    static constexpr std::size_t PlaneOffset = ChunkSize; // Slack before the first row, the stencil reads one float before each chunk
+    static constexpr float MinIntensity = 0.05f; // Weaker heating does not ignite a tile and weaker fires go out
+
+    World& world_;
+    float spreadRate_;
+    float burnRate_;
+    int currentTime_ = 0;
+
+    int width_;
+    int depth_;
+    std::size_t stride_; // Floats per padded row, a multiple of the chunk size
+    std::size_t chunksPerRow_;
+    std::size_t wordsPerRow_; // Bitmap words per row of chunks
+
+    std::vector<float> fuel_;
+    std::vector<float> flammability_; // Vegetation and moisture factor of the tile, 0 for water and padding
+    std::vector<float> intensity_;
+    std::vector<float> nextIntensity_;
+
+    std::vector<uint64_t> active_; // Chunks with fire in the current intensity plane
+    std::vector<uint64_t> previousActive_; // Chunks with fire in the previous one, which is overwritten by the next step
+    std::vector<uint64_t> process_; // Chunks updated in this step
+    std::vector<uint64_t> rowMask_; // Valid chunk bits of one bitmap row
+    std::size_t activeChunks_ = 0;
+
+    std::vector<Tile*> prohibitedTiles_;
+    std::vector<Tile*> lastChangedTiles_;
+
+    struct StateParameters {
+        std::shared_ptr<TypedVectorParameter<bool>> isBurning;
+        std::shared_ptr<TypedVectorParameter<bool>> hasBurned;
+        std::shared_ptr<TypedVectorParameter<int>> burningFor;
+        std::shared_ptr<TypedVectorParameter<int>> ignitionTime;
+    };
+
+public:
+    // spreadRate scales how strongly burning neighbors heat a tile, burnRate is the fuel a tile burning at full intensity consumes per step.
+    explicit FuelSimulation(World& world, float spreadRate = 1.0f, float burnRate = 0.25f)
+            : world_(world), spreadRate_(spreadRate), burnRate_(burnRate), width_(world.GetWidth()), depth_(world.GetDepth()) {
+        stride_ = (static_cast<std::size_t>(depth_) + 2 + ChunkSize - 1) / ChunkSize * ChunkSize;
+        chunksPerRow_ = stride_ / ChunkSize;
+        wordsPerRow_ = (chunksPerRow_ + 63) / 64;
+
+        rowMask_.assign(wordsPerRow_, ~uint64_t(0));
+        if (chunksPerRow_ % 64 != 0) {
+            rowMask_.back() = (uint64_t(1) << (chunksPerRow_ % 64)) - 1;
+        }
+
+        InitWorldParameters();
+        InitPlanes();
+        for (auto& row : world_.grid) {
+            for (auto* tile : row) {
+                if (tile != nullptr && tile->GetMoisture() == 100) {
+                    prohibitedTiles_.push_back(tile);
+                }
+            }
+        }
+    }
+
+    // Adds the same global and per-tile parameters as FireSpreadSimulation, so exporters, recorders and the visualizer work unchanged.
+    void InitWorldParameters() {
+        size_t totalTiles = world_.GetWidth() * world_.GetDepth();
+        world_.AddParameter("windSpeed", std::make_shared<TypedParameter<float>>(5.0f, 0.0f, 50.0f));
+        world_.AddParameter("windDirection", std::make_shared<TypedParameter<int>>(0, 0, 360));
+        world_.AddVectorParameter<bool>("isBurning", totalTiles, false, false, true);
+        world_.AddVectorParameter<bool>("hasBurned", totalTiles, false, false, true);
+        world_.AddVectorParameter<int>("burningFor", totalTiles, 0, 0, std::numeric_limits<int>::max());
+        world_.AddVectorParameter<int>("ignitionTime", totalTiles, -1, -1, std::numeric_limits<int>::max());
+    }
+
+    // Sets full intensity on the starting tiles.
+    void Initialize(std::vector<Tile*>& startingTiles) override {
+        auto isBurningParam = world_.GetVectorParameter<bool>("isBurning");
+        auto ignitionTimeParam = world_.GetVectorParameter<int>("ignitionTime");
+        lastChangedTiles_.clear();
+        events_.Clear();
+        for (auto* tile : startingTiles) {
+            std::size_t index = GetPlaneIndex(tile->GetWidthPosition(), tile->GetDepthPosition());
+            if (fuel_[index] <= 0) {
+                continue; // Nothing to burn
+            }
+            intensity_[index] = 1.0f;
+            isBurningParam->SetValue(world_.GetTileIndex(tile), true);
+            ignitionTimeParam->SetValue(world_.GetTileIndex(tile), currentTime_);
+            SetActive(active_, index);
+            lastChangedTiles_.push_back(tile);
+            events_.Ignite(static_cast<uint32_t>(world_.GetTileIndex(tile)));
+        }
+        activeChunks_ = CountBits(active_);
+        events_.Publish(currentTime_);
+    }
+
+    // Updates every chunk with fire in or next to it.
+    void Update() override {
+        currentTime_++;
+        lastChangedTiles_.clear();
+
+        float weights[8];
+        std::ptrdiff_t offsets[8];
+        GetStencil(weights, offsets);
+
+        StateParameters parameters{world_.GetVectorParameter<bool>("isBurning"), world_.GetVectorParameter<bool>("hasBurned"),
+                                   world_.GetVectorParameter<int>("burningFor"), world_.GetVectorParameter<int>("ignitionTime")};
+        BuildProcessSet();
+        std::fill(previousActive_.begin(), previousActive_.end(), 0); // Becomes the activity of the next intensity plane
+
+        bool useAvx2 = CpuFeatures::HasAvx2();
+        for (int x = 1; x <= width_; ++x) {
+            std::size_t rowWord = static_cast<std::size_t>(x) * wordsPerRow_;
+            for (std::size_t word = 0; word < wordsPerRow_; ++word) {
+                for (uint64_t bits = process_[rowWord + word]; bits != 0; bits &= bits - 1) {
+                    std::size_t chunk = word * 64 + CountTrailingZeros(bits);
+                    std::size_t index = PlaneOffset + static_cast<std::size_t>(x) * stride_ + chunk * ChunkSize;
+                    bool active;
+#if FIRESIM_X86_SIMD
+                    if (useAvx2) {
+                        active = UpdateChunkAvx2(index, weights, offsets);
+                    } else {
+                        active = UpdateChunk(index, weights, offsets);
+                    }
+#else
+                    (void) useAvx2;
+                    active = UpdateChunk(index, weights, offsets);
+#endif
+                    if (active) {
+                        previousActive_[rowWord + word] |= uint64_t(1) << (chunk % 64);
+                    }
+                    if (active || (active_[rowWord + word] >> (chunk % 64) & 1)) {
+                        RecordChanges(parameters, x, chunk);
+                    }
+                }
+            }
+        }
+
+        // The new plane becomes current, the old one keeps the previous activity
+        std::swap(intensity_, nextIntensity_);
+        std::swap(active_, previousActive_);
+        activeChunks_ = CountBits(active_);
+        events_.Publish(currentTime_);
+    }
+
+    bool HasEnded() const override {
+        return activeChunks_ == 0;
+    }
+
+    void Reset() override {
+        currentTime_ = 0;
+        lastChangedTiles_.clear();
+        events_.Clear();
+        InitPlanes();
+
+        world_.ResetParameters();
+        for (auto& row : world_.grid) {
+            for (auto& tile : row) {
+                tile->ResetParameters();
+            }
+        }
+    }
+
+    const std::vector<Tile*>& GetLastChangedTiles() const override {
+        return lastChangedTiles_;
+    }
+
+    std::vector<Tile*> GetProhibitedTiles() const override {
+        return prohibitedTiles_;
+    }
+
+    // Burning tiles are shaded by their intensity.
+    std::unordered_map<int, sf::Color> GetChangedTileColors() const override {
+        std::unordered_map<int, sf::Color> tileColors;
+        for (auto* tile : lastChangedTiles_) {
+            float intensity = GetIntensity(tile);
+            int tileIndex = static_cast<int>(world_.GetTileIndex(tile));
+            if (intensity > 0) {
+                sf::Color color = FireSpreadSimulation::GetTileStateColor(TileState::Burning);
+                float shade = 0.5f + 0.5f * intensity;
+                tileColors[tileIndex] = sf::Color(static_cast<sf::Uint8>(color.r * shade), static_cast<sf::Uint8>(color.g * shade),
+                                                  static_cast<sf::Uint8>(color.b * shade));
+            } else {
+                tileColors[tileIndex] = FireSpreadSimulation::GetTileStateColor(TileState::Burned);
+            }
+        }
+        return tileColors;
+    }
+
+    float GetIntensity(Tile* tile) const {
+        return intensity_[GetPlaneIndex(tile->GetWidthPosition(), tile->GetDepthPosition())];
+    }
+
+    float GetFuel(Tile* tile) const {
+        return fuel_[GetPlaneIndex(tile->GetWidthPosition(), tile->GetDepthPosition())];
+    }
+
+    // Initial fuel load of a tile, sized so that a tile burning at full intensity burns out after the vegetation's burn time.
+    float GetFuelLoad(VegetationType vegetation) const {
+        return burnRate_ * static_cast<float>(FireSpreadSimulation::GetBurnTime(vegetation));
+    }
+
+private:
+    std::size_t GetPlaneIndex(int x, int y) const {
+        return PlaneOffset + static_cast<std::size_t>(x + 1) * stride_ + static_cast<std::size_t>(y + 1);
+    }
+
+    void InitPlanes() {
+        std::size_t planeSize = PlaneOffset + static_cast<std::size_t>(width_ + 2) * stride_ + ChunkSize;
+        fuel_.assign(planeSize, 0.0f);
+        flammability_.assign(planeSize, 0.0f);
+        intensity_.assign(planeSize, 0.0f);
+        nextIntensity_.assign(planeSize, 0.0f);
+
+        std::size_t bitmapSize = static_cast<std::size_t>(width_ + 2) * wordsPerRow_;
+        active_.assign(bitmapSize, 0);
+        previousActive_.assign(bitmapSize, 0);
+        process_.assign(bitmapSize, 0);
+        activeChunks_ = 0;
+
+        for (int x = 0; x < width_; ++x) {
+            for (int y = 0; y < depth_; ++y) {
+                Tile* tile = world_.GetTileAt(x, y);
+                if (tile->GetMoisture() == 100) {
+                    continue; // Water does not burn
+                }
+                std::size_t index = GetPlaneIndex(x, y);
+                fuel_[index] = GetFuelLoad(tile->GetVegetation());
+                flammability_[index] = FireSpreadSimulation::GetVegetationFactor(tile->GetVegetation(), 1.0f) *
+                                       FireSpreadSimulation::GetMoistureFactor(tile->GetMoisture(), 1.0f);
+            }
+        }
+    }
+
+    // Weights and plane offsets of the 8 neighbors. The weight of a neighbor is the heat it passes on at full intensity, lower for diagonal
+    // neighbors and higher downwind. Terrain slope is not modelled, it would need a weight per tile and direction.
+    void GetStencil(float* weights, std::ptrdiff_t* offsets) const {
+        float windSpeed = world_.GetParameter<float>("windSpeed")->GetValue();
+        int windDirection = world_.GetParameter<int>("windDirection")->GetValue();
+        const int deltas[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+        for (int direction = 0; direction < 8; ++direction) {
+            int deltaX = deltas[direction][0];
+            int deltaY = deltas[direction][1];
+            float distance = (deltaX != 0 && deltaY != 0) ? std::sqrt(2.0f) : 1.0f;
+            // Fire spreads from the neighbor to this tile, i.e. in the direction opposite to the offset
+            float windFactor = FireSpreadSimulation::GetWindFactor(windSpeed, windDirection, -deltaX, -deltaY, 1.0f);
+            weights[direction] = spreadRate_ * windFactor / distance;
+            offsets[direction] = static_cast<std::ptrdiff_t>(deltaX) * static_cast<std::ptrdiff_t>(stride_) + deltaY;
+        }
+    }
+
+    // Chunks to update: every chunk with fire or next to one, plus the chunks that had fire in the plane about to be overwritten.
+    void BuildProcessSet() {
+        std::vector<uint64_t> vertical(wordsPerRow_);
+        for (int x = 1; x <= width_; ++x) {
+            std::size_t rowWord = static_cast<std::size_t>(x) * wordsPerRow_;
+            for (std::size_t word = 0; word < wordsPerRow_; ++word) {
+                vertical[word] = active_[rowWord - wordsPerRow_ + word] | active_[rowWord + word] | active_[rowWord + wordsPerRow_ + word];
+            }
+            for (std::size_t word = 0; word < wordsPerRow_; ++word) {
+                uint64_t bits = vertical[word];
+                uint64_t dilated = bits | bits << 1 | bits >> 1;
+                if (word > 0) {
+                    dilated |= vertical[word - 1] >> 63;
+                }
+                if (word + 1 < wordsPerRow_) {
+                    dilated |= vertical[word + 1] << 63;
+                }
+                process_[rowWord + word] = (dilated | previousActive_[rowWord + word]) & rowMask_[word];
+            }
+        }
+    }
+
+    // Scalar kernel, auto-vectorized on targets without a dedicated kernel. Returns whether the chunk still has fire. A tile with fuel at
+    // the start of a step burns through it, also when the step consumes its last fuel, so every ignition passes heat on before it burns out.
+    bool UpdateChunk(std::size_t index, const float* weights, const std::ptrdiff_t* offsets) {
+        const float* intensity = intensity_.data() + index;
+        float* next = nextIntensity_.data() + index;
+        float* fuel = fuel_.data() + index;
+        const float* flammability = flammability_.data() + index;
+
+        bool active = false;
+        for (int i = 0; i < ChunkSize; ++i) {
+            float heat = 0.0f;
+            for (int direction = 0; direction < 8; ++direction) {
+                heat = heat + weights[direction] * intensity[i + offsets[direction]];
+            }
+            float ignited = std::min(1.0f, intensity[i] + flammability[i] * heat);
+            ignited = ignited >= MinIntensity ? ignited : 0.0f;
+            float remaining = fuel[i] - std::min(fuel[i], ignited * burnRate_);
+            next[i] = fuel[i] > 0.0f ? ignited : 0.0f;
+            fuel[i] = remaining;
+            active |= next[i] > 0.0f;
+        }
+        return active;
+    }
+
+#if FIRESIM_X86_SIMD
+    // AVX2 version of UpdateChunk, one chunk per vector. Uses the same operations in the same order, so results are identical.
+    FIRESIM_TARGET_AVX2 bool UpdateChunkAvx2(std::size_t index, const float* weights, const std::ptrdiff_t* offsets) {
+        const float* intensity = intensity_.data() + index;
+        float* fuel = fuel_.data() + index;
+
+        __m256 heat = _mm256_setzero_ps();
+        for (int direction = 0; direction < 8; ++direction) {
+            __m256 neighbor = _mm256_loadu_ps(intensity + offsets[direction]);
+            heat = _mm256_add_ps(heat, _mm256_mul_ps(_mm256_set1_ps(weights[direction]), neighbor));
+        }
+
+        __m256 zero = _mm256_setzero_ps();
+        __m256 ignited = _mm256_min_ps(_mm256_set1_ps(1.0f),
+                                       _mm256_add_ps(_mm256_loadu_ps(intensity), _mm256_mul_ps(_mm256_loadu_ps(flammability_.data() + index), heat)));
+        ignited = _mm256_and_ps(ignited, _mm256_cmp_ps(ignited, _mm256_set1_ps(MinIntensity), _CMP_GE_OQ));
+
+        __m256 currentFuel = _mm256_loadu_ps(fuel);
+        __m256 remaining = _mm256_sub_ps(currentFuel, _mm256_min_ps(currentFuel, _mm256_mul_ps(ignited, _mm256_set1_ps(burnRate_))));
+        _mm256_storeu_ps(fuel, remaining);
+
+        __m256 next = _mm256_and_ps(ignited, _mm256_cmp_ps(currentFuel, zero, _CMP_GT_OQ));
+        _mm256_storeu_ps(nextIntensity_.data() + index, next);
+        return _mm256_movemask_ps(_mm256_cmp_ps(next, zero, _CMP_GT_OQ)) != 0;
+    }
+#endif
+
+    // Mirrors ignitions and burnouts of a chunk into the world parameters and collects the tiles whose color changes.
+    void RecordChanges(const StateParameters& parameters, int x, std::size_t chunk) {
+        int firstY = std::max(0, static_cast<int>(chunk * ChunkSize) - 1);
+        int lastY = std::min(depth_, static_cast<int>((chunk + 1) * ChunkSize) - 1);
+        for (int y = firstY; y < lastY; ++y) {
+            std::size_t index = GetPlaneIndex(x - 1, y);
+            float before = intensity_[index];
+            float after = nextIntensity_[index];
+            if (before == 0.0f && after == 0.0f) {
+                continue;
+            }
+
+            std::size_t tileIndex = static_cast<std::size_t>(x - 1) * depth_ + y;
+            if (before == 0.0f) {
+                parameters.isBurning->SetValue(tileIndex, true);
+                parameters.ignitionTime->SetValue(tileIndex, currentTime_);
+                events_.Ignite(static_cast<uint32_t>(tileIndex));
+            } else if (after == 0.0f) {
+                parameters.isBurning->SetValue(tileIndex, false);
+                parameters.hasBurned->SetValue(tileIndex, true);
+                events_.BurnOut(static_cast<uint32_t>(tileIndex));
+            }
+            if (after > 0.0f) {
+                parameters.burningFor->SetValue(tileIndex, parameters.burningFor->GetValue(tileIndex) + 1);
+            }
+
+            // Only ignitions, burnouts and visible changes of the shade are redrawn
+            if (before == 0.0f || after == 0.0f || static_cast<int>(before * 8) != static_cast<int>(after * 8)) {
+                lastChangedTiles_.push_back(world_.grid[x - 1][y]);
+            }
+        }
+    }
+
+    void SetActive(std::vector<uint64_t>& bitmap, std::size_t planeIndex) const {
+        std::size_t row = (planeIndex - PlaneOffset) / stride_;
+        std::size_t chunk = (planeIndex - PlaneOffset) % stride_ / ChunkSize;
+        bitmap[row * wordsPerRow_ + chunk / 64] |= uint64_t(1) << (chunk % 64);
+    }
+
+    static std::size_t CountBits(const std::vector<uint64_t>& bitmap) {
+        std::size_t count = 0;
+        for (auto word : bitmap) {
+            count += static_cast<std::size_t>(__builtin_popcountll(word));
+        }
+        return count;
+    }
+
+    static int CountTrailingZeros(uint64_t bits) {
+        return __builtin_ctzll(bits);
+    }
+};
@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+
+#include "fastMarchingSimulation.h"
+#include "policySimulation.h"
+#include "taskScheduler.h"
+
+// Settings of the ignition risk evaluation.
+struct IgnitionRiskSettings {
+    float horizon = 50.0f;  // Steps after the ignition at which the consequence is measured
+    int finalists = 32;     // Best screened candidates that are re-scored by Monte Carlo
+    int monteCarloRuns = 16; // Stochastic runs per finalist
+    int stride = 1;         // Risk maps score every stride-th tile along each axis
+    uint32_t seed = 0;      // Seed of the first Monte Carlo run, run i uses seed + i
+};
+
+// Score of one candidate ignition set.
+struct IgnitionCandidateScore {
+    std::size_t candidate = 0;     // Index of the candidate in the evaluated list
+    float screeningScore = 0;     // Value of the tiles the fire reaches until the horizon along the deterministic arrival times
+    float monteCarloScore = -1.0f; // Mean value of the tiles burning or burned at the horizon over the stochastic runs, -1 if not a finalist
+
+    float Score() const {
+        return monteCarloScore >= 0 ? monteCarloScore : screeningScore;
+    }
+};
+
+// Consequence of igniting every (stride-th) tile, with the candidates ranked from the most to the least damaging.
+struct IgnitionRiskMap {
+    int width = 0;
+    int depth = 0;
+    std::vector<float> consequence; // Per tile index (x * depth + y), scores of sampled tiles cover their stride x stride block
+    std::vector<uint32_t> candidateTiles; // Ignition tile of every candidate in the ranking
+    std::vector<IgnitionCandidateScore> ranking;
+
+    // Writes the consequence as an ESRI ASCII grid, rows being width positions like the raster exporter's.
+    void WriteAsciiGrid(std::ostream& out) const {
+        out << "ncols " << depth << "\nnrows " << width << "\nxllcorner 0\nyllcorner 0\ncellsize 1\nNODATA_value -1\n";
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < depth; ++y) {
+                out << (y == 0 ? "" : " ") << consequence[static_cast<std::size_t>(x) * depth + y];
+            }
+            out << '\n';
+        }
+    }
+};
+
+// Finds the ignition sets a fire would do the most damage from, e.g. to plan prescribed burns or fire watches. Candidates are screened
+// with one deterministic arrival-time solve each, bounded by the horizon so the work scales with the area reached instead of the map.
+// Only the best screened candidates (the finalists) are re-scored by stochastic runs of the spread kernel, which all use the same seeds
+// so the finalists are compared under the same random draws. Both stages run in parallel on the task scheduler.
+//
+// The wind of the world at construction is used for the whole evaluation. The value of a tile (1 by default) weights the consequence,
+// e.g. to count only assets or settlements.
+class IgnitionOptimizer {
+    using Kernel = SpreadKernel<MooreNeighborhood, DirectionalWind, StepSlope, CounterRng, CompactState>;
+
+    World& world_;
+    TaskScheduler& scheduler_;
+    IgnitionRiskSettings settings_;
+    std::vector<float> tileValues_;
+    std::vector<uint8_t> flammable_;
+
+    ArrivalTimeSolver solver_; // Prototype with precomputed travel times, copied by every screening task
+    float windSpeed_;
+    int windDirection_;
+
+public:
+    IgnitionOptimizer(World& world, TaskScheduler& scheduler, IgnitionRiskSettings settings = {}, std::vector<float> tileValues = {})
+            : world_(world), scheduler_(scheduler), settings_(settings), tileValues_(std::move(tileValues)), solver_(world) {
+        std::size_t totalTiles = static_cast<std::size_t>(world_.GetWidth()) * world_.GetDepth();
+        if (settings_.horizon <= 0 || settings_.finalists < 0 || settings_.monteCarloRuns < 1 || settings_.stride < 1) {
+            throw std::invalid_argument("Ignition risk needs a positive horizon, stride and number of runs");
+        }
+        if (tileValues_.empty()) {
+            tileValues_.assign(totalTiles, 1.0f);
+        } else if (tileValues_.size() != totalTiles) {
+            throw std::invalid_argument("Ignition risk needs one value per tile");
+        }
+
+        if (!world_.GetParameter<float>("windSpeed") || !world_.GetParameter<int>("windDirection")) {
+            world_.AddParameter("windSpeed", std::make_shared<TypedParameter<float>>(5.0f, 0.0f, 50.0f));
+            world_.AddParameter("windDirection", std::make_shared<TypedParameter<int>>(0, 0, 360));
+        }
+        windSpeed_ = world_.GetParameter<float>("windSpeed")->GetValue();
+        windDirection_ = world_.GetParameter<int>("windDirection")->GetValue();
+        solver_.PrecomputeTravelTimes();
+
+        flammable_.assign(totalTiles, 0);
+        for (int x = 0; x < world_.GetWidth(); ++x) {
+            for (int y = 0; y < world_.GetDepth(); ++y) {
+                flammable_[static_cast<std::size_t>(x) * world_.GetDepth() + y] = world_.GetTileAt(x, y)->GetMoisture() != 100;
+            }
+        }
+    }
+
+    // Scores the candidate ignition sets (tile indices x * depth + y) and returns them ranked: finalists by their Monte Carlo score first,
+    // then the other candidates by their screening score. Tiles that cannot burn are ignored, like clicks on water in the simulator.
+    std::vector<IgnitionCandidateScore> Evaluate(const std::vector<std::vector<uint32_t>>& candidates) {
+        std::vector<std::vector<uint32_t>> ignitions(candidates.size());
+        for (std::size_t i = 0; i < candidates.size(); ++i) {
+            for (auto tile : candidates[i]) {
+                if (tile >= flammable_.size()) {
+                    throw std::out_of_range("Ignition tile outside the world");
+                }
+                if (flammable_[tile]) {
+                    ignitions[i].push_back(tile);
+                }
+            }
+        }
+
+        std::vector<IgnitionCandidateScore> scores(candidates.size());
+        Screen(ignitions, scores);
+
+        std::vector<IgnitionCandidateScore> ranking = scores;
+        std::stable_sort(ranking.begin(), ranking.end(),
+                         [](const IgnitionCandidateScore& a, const IgnitionCandidateScore& b) { return a.screeningScore > b.screeningScore; });
+        std::size_t finalists = std::min(ranking.size(), static_cast<std::size_t>(settings_.finalists));
+        while (finalists > 0 && ranking[finalists - 1].screeningScore <= 0) {
+            finalists--; // Candidates that cannot spread at all are not worth simulating
+        }
+        SimulateFinalists(ignitions, ranking, finalists);
+        std::stable_sort(ranking.begin(), ranking.begin() + finalists,
+                         [](const IgnitionCandidateScore& a, const IgnitionCandidateScore& b) { return a.monteCarloScore > b.monteCarloScore; });
+        return ranking;
+    }
+
+    // Scores igniting every stride-th flammable tile on its own and spreads the scores into a map over the whole world.
+    IgnitionRiskMap BuildRiskMap() {
+        IgnitionRiskMap map;
+        map.width = world_.GetWidth();
+        map.depth = world_.GetDepth();
+        map.consequence.assign(flammable_.size(), -1.0f);
+
+        std::vector<std::vector<uint32_t>> candidates;
+        for (int x = 0; x < map.width; x += settings_.stride) {
+            for (int y = 0; y < map.depth; y += settings_.stride) {
+                uint32_t tile = static_cast<uint32_t>(x * map.depth + y);
+                if (flammable_[tile]) {
+                    map.candidateTiles.push_back(tile);
+                    candidates.push_back({tile});
+                }
+            }
+        }
+        map.ranking = Evaluate(candidates);
+
+        for (const auto& score : map.ranking) {
+            int tileX = static_cast<int>(map.candidateTiles[score.candidate]) / map.depth;
+            int tileY = static_cast<int>(map.candidateTiles[score.candidate]) % map.depth;
+            for (int x = tileX; x < std::min(tileX + settings_.stride, map.width); ++x) {
+                for (int y = tileY; y < std::min(tileY + settings_.stride, map.depth); ++y) {
+                    map.consequence[static_cast<std::size_t>(x) * map.depth + y] = score.Score();
+                }
+            }
+        }
+        return map;
+    }
+
+private:
+    // Screening stage: one bounded arrival-time solve per candidate, every part of the candidate range with its own copy of the solver.
+    void Screen(const std::vector<std::vector<uint32_t>>& ignitions, std::vector<IgnitionCandidateScore>& scores) {
+        scheduler_.ParallelFor(0, ignitions.size(), 0, [this, &ignitions, &scores](std::size_t from, std::size_t to) {
+            ArrivalTimeSolver solver = solver_;
+            for (std::size_t i = from; i < to; ++i) {
+                float value = 0;
+                if (!ignitions[i].empty()) {
+                    for (auto tile : solver.Solve(ignitions[i], settings_.horizon)) {
+                        value += tileValues_[tile];
+                    }
+                }
+                scores[i].candidate = i;
+                scores[i].screeningScore = value;
+            }
+        });
+    }
+
+    // Monte Carlo stage: every part re-uses one kernel (and its probability table) for its share of the finalists.
+    void SimulateFinalists(const std::vector<std::vector<uint32_t>>& ignitions, std::vector<IgnitionCandidateScore>& ranking, std::size_t finalists) {
+        std::size_t parts = std::min(finalists, scheduler_.GetThreadCount());
+        scheduler_.ParallelFor(0, parts, 1, [this, &ignitions, &ranking, finalists, parts](std::size_t fromPart, std::size_t toPart) {
+            Kernel kernel(world_.GetTerrainPlanes(), settings_.seed);
+            for (std::size_t part = fromPart; part < toPart; ++part) {
+                for (std::size_t rank = part; rank < finalists; rank += parts) {
+                    const auto& ignition = ignitions[ranking[rank].candidate];
+                    double total = 0;
+                    for (int run = 0; run < settings_.monteCarloRuns; ++run) {
+                        kernel.Reseed(settings_.seed + static_cast<uint32_t>(run));
+                        total += SimulateRun(kernel, ignition);
+                    }
+                    ranking[rank].monteCarloScore = static_cast<float>(total / settings_.monteCarloRuns);
+                }
+            }
+        });
+    }
+
+    // Value of the tiles burning or burned at the horizon of one stochastic run.
+    float SimulateRun(Kernel& kernel, const std::vector<uint32_t>& ignition) {
+        kernel.Reset(world_);
+        kernel.Ignite(ignition);
+        float value = 0;
+        for (auto tile : kernel.GetChanged()) {
+            value += tileValues_[tile];
+        }
+        while (!kernel.HasEnded() && kernel.GetTime() < settings_.horizon) {
+            kernel.Step(windSpeed_, windDirection_);
+            for (auto tile : kernel.GetChanged()) {
+                if (kernel.GetState().Get(tile) == TileState::Burning) {
+                    value += tileValues_[tile]; // Newly ignited, tiles burning out were counted when they ignited
+                }
+            }
+        }
+        return value;
+    }
+};
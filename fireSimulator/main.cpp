@@ -9,16 +9,23 @@
 #include "worldGenerator.h"
 #include "visualizer.h"
 #include "simulation.h"
+#include "smokeSimulation.h"
+#include "replay.h"
 
-class MainLogic {
+class MainLogic : public SimulationObserver {
 private:
     std::shared_ptr<World> world; // World object to hold the simulation state
     int worldSize = 30; // Choose a world size
 
     std::unique_ptr<Simulation> simulation;
+    std::unique_ptr<SmokeSimulation> smoke; // Smoke of the fire, drawn as an overlay
     std::vector<Tile*> initTiles; // Initially burning tiles for simulation
     std::vector<Tile*> prohibitedTiles; // Initially burning tiles for simulation
 
+    std::unique_ptr<SimulationRecorder> recorder; // Records the running simulation so it can be replayed
+    std::unique_ptr<ReplayPlayer> replayPlayer; // Created when the user starts scrubbing through a stopped simulation
+    int replayStride = 1; // Number of steps one arrow key press moves the replay
+
     Visualizer visualizer; // The visualizer for rendering
 
     bool isMouseButtonPressed = false;
@@ -84,6 +91,10 @@ private:
                 visualizer.highlightTile(x , y);
                 clock.restart();
             }
+            else if (event.type == sf::Event::KeyPressed) {
+                handleKeyInteraction(event.key.code);
+                clock.restart();
+            }
         }
     }
 
@@ -111,6 +122,32 @@ private:
         }
     }
 
+    // Lets the user scrub through the recorded run while the simulation is stopped. Left/Right move the replay backwards/forwards, Up/Down change how many steps one press moves.
+    void handleKeyInteraction(sf::Keyboard::Key key) {
+        if (state != GameState::Stopped || !recorder) {
+            return;
+        }
+
+        switch (key) {
+            case sf::Keyboard::Left:
+                seekReplay(currentReplayStep() - replayStride);
+                break;
+            case sf::Keyboard::Right:
+                seekReplay(currentReplayStep() + replayStride);
+                break;
+            case sf::Keyboard::Up:
+                replayStride = std::min(replayStride * 2, 1024);
+                std::cout << "Replay speed: " << replayStride << " steps" << std::endl;
+                break;
+            case sf::Keyboard::Down:
+                replayStride = std::max(replayStride / 2, 1);
+                std::cout << "Replay speed: " << replayStride << " steps" << std::endl;
+                break;
+            default:
+                break;
+        }
+    }
+
     // Handles clicks on UI buttons. It provides a direct interface for controlling the simulation flow.
     void handleButtonInteraction(const sf::Vector2i& mousePos) {
         int buttonIndex = visualizer.checkButtonClick(mousePos, true);
@@ -145,9 +182,8 @@ private:
                 break;
             case GameState::Running:
                 if (simulation && updateClock.getElapsedTime().asSeconds() > updateInterval) {
-                    simulation->Update();
-                    auto changedTiles = simulation->GetChangedTileColors();
-                    visualizer.updateTileColors(changedTiles);
+                    simulation->Update(); // Recorded and shown by OnStepCompleted
+                    updateSmoke();
                     visualizer.redrawElements();
                     updateClock.restart(); // Restart the clock after an update
 
@@ -165,16 +201,41 @@ private:
 
     //  It's a preparatory step before the simulation can run, ensuring it has all necessary initial conditions.
     void initializeSimulation() {
-        simulation = std::make_unique<FireSpreadSimulation>(*world);
+        auto fire = std::make_unique<FireSpreadSimulation>(*world);
+        fire->SetScheduler(&TaskScheduler::Shared());
+        smoke = std::make_unique<SmokeSimulation>(*world, *fire, 2, &TaskScheduler::Shared());
+        simulation = std::move(fire);
+        simulation->Subscribe(*this, StepCompletedEvents);
         simulation->Initialize(initTiles);
+        smoke->Initialize(initTiles);
         prohibitedTiles.clear();
         prohibitedTiles = simulation->GetProhibitedTiles();
     }
 
+    // Records the changes of every step of the fire, starting with Initialize, and shows them.
+    void OnStepCompleted(const StepChanges& changes) override {
+        if (recorder) {
+            recorder->OnStepCompleted(changes);
+        }
+        visualizer.updateTileStates(changes.tiles, changes.states);
+    }
+
+    // Advances the smoke by one step of the fire and shows it over the tiles.
+    void updateSmoke() {
+        if (!smoke) {
+            return;
+        }
+        smoke->Update();
+        visualizer.setOverlay(smoke->GetConcentrations(), smoke->GetGridWidth(), smoke->GetGridDepth(), smoke->GetCellSize(), 1.0f,
+                              sf::Color(90, 90, 90, 180));
+    }
+
     // Creates and prepares a new simulation world and initializes the visualizer with it.
     void generateNewWorld() {
         WorldGenerator worldGenerator(worldSize, worldSize, 0.15f, 3);
+        worldGenerator.scheduler = &TaskScheduler::Shared();
         world = worldGenerator.Generate();
+        recorder.reset(); // Recorded the old world
         visualizer.setWorld(world);
         visualizer.redrawElements();
 
@@ -191,18 +252,40 @@ private:
         // If simulation is already running or paused, this acts as continue with simulation
         if (state == GameState::Stopped || state == GameState::NewWorld) {
             if (state == GameState::NewWorld) {
-                // Only initialize the simulation if it's in the NewWorld state
+                // Only initialize the simulation if it's in the NewWorld state. The recorder receives step 0 from Initialize.
+                recorder = std::make_unique<SimulationRecorder>(*world);
                 initializeSimulation();
-                auto changedTiles = simulation->GetChangedTileColors();
-                visualizer.updateTileColors(changedTiles);
                 visualizer.redrawElements();
             }
+            if (replayPlayer) {
+                // Continue from where the simulation stopped, not from the replayed step
+                seekReplay(recorder->GetStepCount() - 1);
+                replayPlayer.reset();
+            }
             state = GameState::Running;
             updateClock.restart(); // Restart the clock when the simulation starts or continues
             std::cout << "Simulation running..." << std::endl;
         }
     }
 
+    // Step shown on the screen, the last recorded one unless the user is replaying.
+    int currentReplayStep() const {
+        return replayPlayer ? replayPlayer->GetCurrentStep() : recorder->GetStepCount() - 1;
+    }
+
+    // Shows the recorded simulation state at the given step.
+    void seekReplay(int step) {
+        if (!replayPlayer) {
+            replayPlayer = std::make_unique<ReplayPlayer>(*recorder);
+            replayPlayer->Seek(recorder->GetStepCount() - 1); // Matches what is already on the screen
+        }
+        replayPlayer->Seek(step);
+        visualizer.restoreTileColors(replayPlayer->GetRestoredTiles());
+        visualizer.updateTileColors(replayPlayer->GetChangedTileColors());
+        visualizer.redrawElements();
+        std::cout << "Replay step " << replayPlayer->GetCurrentStep() << std::endl;
+    }
+
     // Pauses the simulation, allowing it to be resumed later.
     void stopSimulation() {
         state = GameState::Stopped;
@@ -212,10 +295,15 @@ private:
     void resetSimulation() {
         state = GameState::NewWorld;
         initTiles.clear();
+        replayPlayer.reset();
+        recorder.reset();
 
         if (simulation) {
             simulation->Reset();
         }
+        if (smoke) {
+            smoke->Reset();
+        }
 
         visualizer.Reset();
     }
@@ -0,0 +1,101 @@
+#include <SFML/Graphics.hpp>
+
+#include <chrono>
+#include <iostream>
+
+#include "numaSimulation.h"
+#include "worldGenerator.h"
+
+// Scaling of NUMA-banded runs (see numaSimulation.h) over the nodes of the host: the same fire, lit on a lattice of tiles so every band
+// has work, runs on one worker, then on 1, 2, ... nodes with a fixed number of workers per node. Every run must match the first one.
+// Usage: fireNumaBench [--size=2000] [--steps=300] [--spacing=100] [--workers-per-node=N] [--seed=1] [--no-pin]
+int main(int argc, char* argv[]) {
+    try {
+        int size = 2000;
+        int steps = 300;
+        int spacing = 100;
+        int seed = 1;
+        NumaSettings settings;
+        for (int i = 1; i < argc; ++i) {
+            std::string option = argv[i];
+            std::size_t equals = option.find('=');
+            std::string key = option.substr(0, equals);
+            std::string value = equals == std::string::npos ? "" : option.substr(equals + 1);
+            if (key == "--size") {
+                size = std::stoi(value);
+            } else if (key == "--steps") {
+                steps = std::stoi(value);
+            } else if (key == "--spacing") {
+                spacing = std::max(1, std::stoi(value));
+            } else if (key == "--workers-per-node") {
+                settings.workersPerNode = std::stoi(value);
+            } else if (key == "--seed") {
+                seed = std::stoi(value);
+            } else if (key == "--no-pin") {
+                settings.pinWorkers = false;
+            } else {
+                throw std::runtime_error("Unknown option: " + option);
+            }
+        }
+
+        NumaTopology topology = NumaTopology::Detect();
+        std::cout << "NUMA nodes: " << topology.GetNodeCount() << " (CPUs per node:";
+        for (std::size_t node = 0; node < topology.GetNodeCount(); ++node) {
+            std::cout << " " << topology.GetCpus(node).size();
+        }
+        std::cout << ")" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        TerrainPlanes terrain;
+        std::vector<uint32_t> ignitions;
+        {
+            WorldGenerator generator(size, size, 0.15f, 3, static_cast<unsigned int>(seed));
+            generator.scheduler = &TaskScheduler::Shared();
+            auto world = generator.Generate();
+            terrain = world->GetTerrainPlanes();
+        }
+        for (int x = spacing / 2; x < size; x += spacing) {
+            for (int y = spacing / 2; y < size; y += spacing) {
+                std::size_t tile = static_cast<std::size_t>(x) * size + y;
+                if (terrain.moisture[tile] != 100) {
+                    ignitions.push_back(static_cast<uint32_t>(tile));
+                }
+            }
+        }
+        std::cout << size << "x" << size << " world with " << ignitions.size() << " ignitions generated in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+
+        auto wind = [](int) { return std::pair<float, int>(10.0f, 45); };
+        std::vector<NumaSettings> runs;
+        runs.push_back({1, 1, settings.pinWorkers});
+        for (int nodes = 1; nodes <= static_cast<int>(topology.GetNodeCount()); ++nodes) {
+            runs.push_back({nodes, settings.workersPerNode, settings.pinWorkers});
+        }
+
+        DistributedResult reference;
+        double baseline = 0;
+        bool allMatched = true;
+        for (std::size_t run = 0; run < runs.size(); ++run) {
+            NumaSimulation simulation(terrain, topology, runs[run], static_cast<uint32_t>(seed));
+            start = std::chrono::steady_clock::now();
+            DistributedResult result = simulation.Run(ignitions, wind, steps);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            bool matches = true;
+            if (run == 0) {
+                reference = std::move(result);
+                baseline = seconds;
+            } else {
+                matches = result.steps == reference.steps && result.isBurning == reference.isBurning && result.hasBurned == reference.hasBurned &&
+                          result.burningFor == reference.burningFor && result.ignitionTimes == reference.ignitionTimes;
+                allMatched = allMatched && matches;
+            }
+            std::cout << runs[run].nodes << " node(s), " << simulation.GetSubdomains().size() << " worker(s): " << seconds << " s, speedup "
+                      << baseline / seconds << (matches ? "" : ", result differs from the single-worker run") << std::endl;
+        }
+        return allMatched ? 0 : 2;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,265 @@
+#pragma once
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <sched.h>
+
+#include "distributedSimulation.h"
+
+// NUMA nodes of the host and the CPUs of each that this process may run on. Read from sysfs, hosts without NUMA information (or other
+// systems) count as a single node with all allowed CPUs. Nodes without allowed CPUs, e.g. memory-only nodes, are left out.
+class NumaTopology {
+    std::vector<std::vector<int>> nodeCpus_;
+
+public:
+    explicit NumaTopology(std::vector<std::vector<int>> nodeCpus) : nodeCpus_(std::move(nodeCpus)) {
+        if (nodeCpus_.empty()) {
+            throw std::invalid_argument("A NUMA topology needs at least one node");
+        }
+    }
+
+    static NumaTopology Detect() {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Cannot read the CPU affinity");
+        }
+
+        std::vector<std::vector<int>> nodeCpus;
+        for (int node = 0;; ++node) {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!file) {
+                break;
+            }
+            std::string list;
+            std::getline(file, list);
+            std::vector<int> cpus;
+            for (int cpu : ParseCpuList(list)) {
+                if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+                    cpus.push_back(cpu);
+                }
+            }
+            if (!cpus.empty()) {
+                nodeCpus.push_back(std::move(cpus));
+            }
+        }
+
+        if (nodeCpus.empty()) {
+            std::vector<int> cpus;
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &allowed)) {
+                    cpus.push_back(cpu);
+                }
+            }
+            nodeCpus.push_back(std::move(cpus));
+        }
+        return NumaTopology(std::move(nodeCpus));
+    }
+
+    // Parses a kernel CPU list such as "0-3,8-11".
+    static std::vector<int> ParseCpuList(const std::string& list) {
+        std::vector<int> cpus;
+        std::stringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ',')) {
+            if (range.empty()) {
+                continue;
+            }
+            std::size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    std::size_t GetNodeCount() const {
+        return nodeCpus_.size();
+    }
+
+    const std::vector<int>& GetCpus(std::size_t node) const {
+        return nodeCpus_.at(node);
+    }
+
+    // Restricts the calling thread to the CPUs of the node. Memory the thread touches first from then on is placed on that node.
+    void PinCurrentThread(std::size_t node) const {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu : GetCpus(node)) {
+            CPU_SET(cpu, &cpus);
+        }
+        int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error != 0) {
+            throw std::system_error(error, std::generic_category(), "Cannot pin a worker to NUMA node " + std::to_string(node));
+        }
+    }
+};
+
+// Settings of a NUMA-banded run.
+struct NumaSettings {
+    int nodes = 0;          // Nodes to run on, 0 for all of them
+    int workersPerNode = 0; // 0 for one per CPU of the smallest node used
+    bool pinWorkers = true; // Without pinning the workers still own their bands, but the scheduler may move them to any node
+};
+
+// Runs the spread rules of DistributedSimulation in threads of one process, with the world split into bands of rows: every NUMA node owns a
+// contiguous band, divided further between that node's workers. Each worker is pinned to its node and builds the terrain and state planes
+// of its band itself, so first-touch placement puts them into the node's local memory, and only the halo messages of the band borders cross
+// nodes. The result matches a single-process run with the same seed tile for tile, whatever the node and worker counts.
+class NumaSimulation {
+    // Published by every worker once per step; a cache line each, so workers do not invalidate each other's counts
+    struct alignas(64) WorkerSlot {
+        uint64_t burningCount = 0;
+        bool failed = false;
+    };
+
+    TerrainPlanes terrain_;
+    NumaTopology topology_;
+    bool pinWorkers_;
+    uint32_t seed_;
+    std::vector<Subdomain> subdomains_;
+    std::vector<std::size_t> workerNodes_;
+
+public:
+    // Keeps a copy of the terrain, which each worker reads its band from once per run.
+    NumaSimulation(TerrainPlanes terrain, NumaTopology topology, NumaSettings settings, uint32_t seed)
+            : terrain_(std::move(terrain)), topology_(std::move(topology)), pinWorkers_(settings.pinWorkers), seed_(seed) {
+        std::size_t nodes = settings.nodes > 0 ? static_cast<std::size_t>(settings.nodes) : topology_.GetNodeCount();
+        if (nodes > topology_.GetNodeCount()) {
+            throw std::invalid_argument("The host has only " + std::to_string(topology_.GetNodeCount()) + " NUMA nodes");
+        }
+        std::size_t workersPerNode = static_cast<std::size_t>(settings.workersPerNode);
+        if (workersPerNode == 0) {
+            workersPerNode = topology_.GetCpus(0).size();
+            for (std::size_t node = 1; node < nodes; ++node) {
+                workersPerNode = std::min(workersPerNode, topology_.GetCpus(node).size());
+            }
+        }
+        for (std::size_t node = 0; node < nodes; ++node) {
+            workerNodes_.insert(workerNodes_.end(), workersPerNode, node);
+        }
+        subdomains_ = Subdomain::DecomposeRows(terrain_.width, terrain_.depth, static_cast<int>(workerNodes_.size()));
+    }
+
+    const std::vector<Subdomain>& GetSubdomains() const {
+        return subdomains_;
+    }
+
+    // Node the worker of the subdomain runs on.
+    std::size_t GetWorkerNode(std::size_t worker) const {
+        return workerNodes_[worker];
+    }
+
+    // Runs from the ignition tiles (global indices) until the fire is out or maxSteps steps passed, with the same wind callback as
+    // DistributedSimulation::Run. Throws the first error of a worker after all workers stopped.
+    DistributedResult Run(const std::vector<uint32_t>& ignitions, const std::function<std::pair<float, int>(int)>& wind, int maxSteps) {
+        std::size_t workerCount = subdomains_.size();
+        pthread_barrier_t barrier;
+        int error = pthread_barrier_init(&barrier, nullptr, static_cast<unsigned>(workerCount));
+        if (error != 0) {
+            throw std::system_error(error, std::generic_category(), "Cannot create worker barrier");
+        }
+
+        DistributedResult result;
+        std::size_t totalTiles = terrain_.Size();
+        result.isBurning.resize(totalTiles);
+        result.hasBurned.resize(totalTiles);
+        result.burningFor.resize(totalTiles);
+        result.ignitionTimes.resize(totalTiles);
+
+        std::vector<std::unique_ptr<SubdomainKernel>> kernels(workerCount);
+        std::vector<WorkerSlot> slots(workerCount);
+        std::mutex errorMutex;
+        std::exception_ptr firstError;
+
+        auto runWorker = [&](std::size_t worker) {
+            // A failing worker keeps meeting the others at the barrier and publishes the failure, so all of them stop at the same step
+            bool failed = false;
+            auto guard = [&](auto&& action) {
+                if (failed) {
+                    return;
+                }
+                try {
+                    action();
+                } catch (...) {
+                    failed = true;
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!firstError) {
+                        firstError = std::current_exception();
+                    }
+                }
+            };
+
+            guard([&] {
+                if (pinWorkers_) {
+                    topology_.PinCurrentThread(workerNodes_[worker]);
+                }
+                TerrainView view{terrain_.width, terrain_.depth, terrain_.height.data(), terrain_.moisture.data(), terrain_.vegetation.data()};
+                kernels[worker] = std::make_unique<SubdomainKernel>(view, subdomains_[worker], seed_); // First touch on the worker's node
+                kernels[worker]->Ignite(ignitions);
+            });
+            slots[worker].burningCount = failed ? 0 : kernels[worker]->GetBurningCount();
+            slots[worker].failed = failed;
+            pthread_barrier_wait(&barrier);
+
+            int steps = 0;
+            while (steps < maxSteps && !AnyFailed(slots) && TotalBurning(slots) > 0) {
+                auto [windSpeed, windDirection] = wind(steps + 1);
+                guard([&] { kernels[worker]->Step(windSpeed, windDirection); });
+                pthread_barrier_wait(&barrier);
+
+                guard([&] {
+                    for (std::size_t other = 0; other < workerCount; ++other) {
+                        if (other != worker && kernels[other] != nullptr) {
+                            for (uint32_t message : kernels[other]->GetOutbox()) {
+                                kernels[worker]->Receive(message);
+                            }
+                        }
+                    }
+                });
+                slots[worker].burningCount = failed ? 0 : kernels[worker]->GetBurningCount();
+                slots[worker].failed = failed;
+                pthread_barrier_wait(&barrier);
+                steps++;
+            }
+
+            guard([&] {
+                kernels[worker]->WriteState(result.isBurning.data(), result.hasBurned.data(), result.burningFor.data(), result.ignitionTimes.data());
+                kernels[worker].reset(); // Freed by the thread of its node
+            });
+            if (worker == 0) {
+                result.steps = steps;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (std::size_t worker = 0; worker < workerCount; ++worker) {
+            threads.emplace_back(runWorker, worker);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        pthread_barrier_destroy(&barrier);
+        if (firstError) {
+            std::rethrow_exception(firstError);
+        }
+        return result;
+    }
+
+private:
+    static bool AnyFailed(const std::vector<WorkerSlot>& slots) {
+        return std::any_of(slots.begin(), slots.end(), [](const WorkerSlot& slot) { return slot.failed; });
+    }
+
+    static uint64_t TotalBurning(const std::vector<WorkerSlot>& slots) {
+        uint64_t total = 0;
+        for (const auto& slot : slots) {
+            total += slot.burningCount;
+        }
+        return total;
+    }
+};
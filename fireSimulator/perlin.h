@@ -2,6 +2,7 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib> // For rand()
 #include <ctime> // For time()
 
@@ -20,6 +21,84 @@ public:
     }
 };
 
+// Counter-based random number generator. Every draw is a pure function of the seed, the counter and the slot it is drawn for
+// (e.g. a tile and a direction), so results do not depend on the order of the draws and a run can be continued exactly
+// from a checkpoint by restoring just the seed and the counter.
+class CounterRandom {
+public:
+    explicit CounterRandom(uint32_t seed = 0) : seed_(seed), counter_(0) {
+        UpdateStreamKey();
+    }
+
+    // Moves to a new, independent stream of draws, typically once per simulation step.
+    void Advance() {
+        counter_++;
+        UpdateStreamKey();
+    }
+
+    // Random 32 bits for the given slot in the current stream.
+    uint32_t Bits(uint32_t slot) const {
+        return Mix(slot ^ streamKey_);
+    }
+
+    // Random float in [0, 1) for the given slot in the current stream.
+    float Uniform(uint32_t slot) const {
+        return static_cast<float>(Bits(slot) >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Threshold on the raw bits equivalent to comparing Uniform with the probability: Bits(slot) < Threshold(p) exactly when
+    // Uniform(slot) < p, except that a probability of 1 or more misses the single draw of all ones.
+    static uint32_t Threshold(float probability) {
+        if (!(probability > 0.0f)) {
+            return 0;
+        }
+        if (probability >= 1.0f) {
+            return UINT32_MAX;
+        }
+        return static_cast<uint32_t>(std::ceil(static_cast<double>(probability) * 16777216.0)) << 8;
+    }
+
+    // Draws of a separate sub-stream, for models needing several draws per slot without taking slots of the main stream.
+    uint32_t Bits(uint32_t slot, uint32_t subStream) const {
+        return Mix(Mix(slot ^ streamKey_) ^ Mix(subStream + 0x9e3779b9u));
+    }
+
+    float Uniform(uint32_t slot, uint32_t subStream) const {
+        return static_cast<float>(Bits(slot, subStream) >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Key of the current stream, Bits(slot) is Mix(slot ^ key). For kernels drawing several slots at once.
+    uint32_t GetStreamKey() const { return streamKey_; }
+
+    uint32_t GetSeed() const { return seed_; }
+    uint64_t GetCounter() const { return counter_; }
+
+    void SetState(uint32_t seed, uint64_t counter) {
+        seed_ = seed;
+        counter_ = counter;
+        UpdateStreamKey();
+    }
+
+    // 32-bit finalizer of MurmurHash3, a cheap bijective mix with good avalanche.
+    static uint32_t Mix(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x85ebca6bu;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35u;
+        x ^= x >> 16;
+        return x;
+    }
+
+private:
+    uint32_t seed_;
+    uint64_t counter_;
+    uint32_t streamKey_;
+
+    void UpdateStreamKey() {
+        streamKey_ = Mix(seed_ ^ Mix(static_cast<uint32_t>(counter_) ^ Mix(static_cast<uint32_t>(counter_ >> 32) + 0x9e3779b9u)));
+    }
+};
+
 typedef struct {
     float x, y;
 } vector2;
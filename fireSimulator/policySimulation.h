@@ -0,0 +1,410 @@
+#pragma once
+#include <limits>
+
+#include "simulation.h"
+
+// Compile-time policies of the SpreadKernel. Every policy is a small type with static or inline members, so each combination of policies
+// compiles into its own fully inlined inner loop without virtual calls, switches or always-1 spread factors.
+
+// Neighborhoods: offsets of the tiles a burning tile can ignite.
+struct MooreNeighborhood {
+    static constexpr int Count = 8;
+    static constexpr int DeltaX[Count] = {-1, -1, -1, 0, 0, 1, 1, 1}; // In FireSpreadSimulation::GetDirectionIndex order
+    static constexpr int DeltaY[Count] = {-1, 0, 1, -1, 1, -1, 0, 1};
+};
+
+struct VonNeumannNeighborhood {
+    static constexpr int Count = 4;
+    static constexpr int DeltaX[Count] = {-1, 0, 0, 1};
+    static constexpr int DeltaY[Count] = {0, -1, 1, 0};
+};
+
+// Wind models: factor for spreading in a direction.
+struct DirectionalWind {
+    static constexpr bool UsesWind = true;
+    static float Factor(float windSpeed, int windDirection, int deltaX, int deltaY) {
+        return FireSpreadSimulation::GetWindFactor(windSpeed, windDirection, static_cast<float>(deltaX), static_cast<float>(deltaY), 1.0f);
+    }
+};
+
+struct NoWind {
+    static constexpr bool UsesWind = false;
+    static float Factor(float, int, int, int) {
+        return 1.0f;
+    }
+};
+
+// Slope models: factor for spreading from one height to another.
+struct StepSlope {
+    static float Factor(float sourceHeight, float targetHeight) {
+        return targetHeight - sourceHeight >= 0 ? 0.35f : 0.25f;
+    }
+};
+
+struct FlatSlope {
+    static float Factor(float, float) {
+        return 0.3f;
+    }
+};
+
+// Random number generators: a uniform draw for a slot (source tile and direction) in the current step.
+class CounterRng {
+    CounterRandom random_;
+
+public:
+    explicit CounterRng(uint32_t seed) : random_(seed) {}
+    void Advance() { random_.Advance(); }
+    float Uniform(uint32_t slot) const { return random_.Uniform(slot); }
+};
+
+// Cheaper sequential generator. Ignores the slot, so results depend on the order tiles are visited in.
+class XorShiftRng {
+    mutable uint32_t state_;
+
+public:
+    explicit XorShiftRng(uint32_t seed) : state_(CounterRandom::Mix(seed) | 1u) {}
+    void Advance() {}
+    float Uniform(uint32_t) const {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 17;
+        state_ ^= state_ << 5;
+        return static_cast<float>(state_ >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+// State storage: fire state of every tile.
+// CompactState keeps its own byte-sized planes, the simulation adapter mirrors only changed tiles into the world.
+class CompactState {
+    std::vector<TileState> states_;
+    std::vector<uint16_t> burningFor_;
+    std::vector<int32_t> ignitionTimes_;
+
+public:
+    static constexpr bool WritesWorld = false;
+
+    void Attach(World&, std::size_t totalTiles) {
+        states_.assign(totalTiles, TileState::Unburned);
+        burningFor_.assign(totalTiles, 0);
+        ignitionTimes_.assign(totalTiles, -1);
+    }
+
+    TileState Get(std::size_t index) const { return states_[index]; }
+    int GetBurningFor(std::size_t index) const { return burningFor_[index]; }
+    int GetIgnitionTime(std::size_t index) const { return ignitionTimes_[index]; }
+
+    void Ignite(std::size_t index, int time) {
+        states_[index] = TileState::Burning;
+        ignitionTimes_[index] = time;
+    }
+
+    int Burn(std::size_t index) { return ++burningFor_[index]; }
+    void BurnOut(std::size_t index) { states_[index] = TileState::Burned; }
+};
+
+// WorldState works directly on the world's "isBurning", "hasBurned", "burningFor" and "ignitionTime" planes.
+class WorldState {
+    uint8_t* isBurning_ = nullptr;
+    uint8_t* hasBurned_ = nullptr;
+    int* burningFor_ = nullptr;
+    int* ignitionTimes_ = nullptr;
+
+public:
+    static constexpr bool WritesWorld = true;
+
+    void Attach(World& world, std::size_t) {
+        isBurning_ = world.GetVectorParameter<bool>("isBurning")->Data();
+        hasBurned_ = world.GetVectorParameter<bool>("hasBurned")->Data();
+        burningFor_ = world.GetVectorParameter<int>("burningFor")->Data();
+        ignitionTimes_ = world.GetVectorParameter<int>("ignitionTime")->Data();
+    }
+
+    TileState Get(std::size_t index) const {
+        return isBurning_[index] ? TileState::Burning : hasBurned_[index] ? TileState::Burned : TileState::Unburned;
+    }
+    int GetBurningFor(std::size_t index) const { return burningFor_[index]; }
+    int GetIgnitionTime(std::size_t index) const { return ignitionTimes_[index]; }
+
+    void Ignite(std::size_t index, int time) {
+        isBurning_[index] = 1;
+        ignitionTimes_[index] = time;
+    }
+
+    int Burn(std::size_t index) { return ++burningFor_[index]; }
+
+    void BurnOut(std::size_t index) {
+        isBurning_[index] = 0;
+        hasBurned_[index] = 1;
+    }
+};
+
+
+
+// Fire spread kernel with the rules of FireSpreadSimulation, specialized at compile time by its policies. The per-step probability of every
+// tile and direction is tabulated once per wind (using the closed form of GetStepProbability), so a step is a table lookup and a random
+// draw per attempt.
+template <class Neighborhood, class Wind, class Slope, class Rng, class State>
+class SpreadKernel {
+    static constexpr float VegetationFactors[4] = {0.18f, 0.25f, 0.4f, 0.22f}; // In VegetationType order: grass, sparse, forest, swamp
+    static constexpr uint8_t BurnTimes[4] = {1, 2, 4, 3};
+
+    TerrainPlanes terrain_;
+    Rng rng_;
+    State state_;
+    int time_ = 0;
+
+    std::vector<float> probabilities_; // Per tile and neighbor, for the wind below
+    float tableWindSpeed_ = -1.0f;
+    int tableWindDirection_ = -1;
+
+    std::vector<uint32_t> burning_;
+    std::vector<uint32_t> nextBurning_;
+    std::vector<uint32_t> changed_;
+
+public:
+    SpreadKernel(TerrainPlanes terrain, uint32_t seed) : terrain_(std::move(terrain)), rng_(seed) {}
+
+    State& GetState() { return state_; }
+    const State& GetState() const { return state_; }
+
+    int GetTime() const { return time_; }
+
+    // Restarts the random draws from a new seed. The probability table is kept, so repeated runs on the same terrain skip rebuilding it.
+    void Reseed(uint32_t seed) {
+        rng_ = Rng(seed);
+    }
+
+    // Sets the given tiles burning at time 0.
+    void Ignite(const std::vector<uint32_t>& tiles) {
+        time_ = 0;
+        burning_.clear();
+        changed_.clear();
+        for (auto tile : tiles) {
+            if (state_.Get(tile) == TileState::Unburned) {
+                state_.Ignite(tile, time_);
+                burning_.push_back(tile);
+                changed_.push_back(tile);
+            }
+        }
+    }
+
+    // Advances by one step under the given wind.
+    void Step(float windSpeed, int windDirection) {
+        time_++;
+        rng_.Advance();
+        changed_.clear();
+        nextBurning_.clear();
+        if (probabilities_.empty() || (Wind::UsesWind && (windSpeed != tableWindSpeed_ || windDirection != tableWindDirection_))) {
+            BuildProbabilities(windSpeed, windDirection);
+        }
+
+        const int width = terrain_.width;
+        const int depth = terrain_.depth;
+        for (uint32_t tile : burning_) {
+            const int x = static_cast<int>(tile) / depth;
+            const int y = static_cast<int>(tile) % depth;
+            const float* probabilities = probabilities_.data() + static_cast<std::size_t>(tile) * Neighborhood::Count;
+            for (int k = 0; k < Neighborhood::Count; ++k) {
+                const int nx = x + Neighborhood::DeltaX[k];
+                const int ny = y + Neighborhood::DeltaY[k];
+                if (nx < 0 || nx >= width || ny < 0 || ny >= depth) {
+                    continue;
+                }
+                const uint32_t neighbor = static_cast<uint32_t>(nx * depth + ny);
+                if (state_.Get(neighbor) == TileState::Unburned && rng_.Uniform(tile * Neighborhood::Count + k) < probabilities[k]) {
+                    state_.Ignite(neighbor, time_);
+                    nextBurning_.push_back(neighbor);
+                    changed_.push_back(neighbor);
+                }
+            }
+
+            if (state_.Burn(tile) >= BurnTimes[static_cast<int>(terrain_.vegetation[tile])]) {
+                state_.BurnOut(tile);
+                changed_.push_back(tile);
+            } else {
+                nextBurning_.push_back(tile);
+            }
+        }
+        std::swap(burning_, nextBurning_);
+    }
+
+    bool HasEnded() const {
+        return burning_.empty();
+    }
+
+    // Tiles that changed state in the last step or ignition.
+    const std::vector<uint32_t>& GetChanged() const {
+        return changed_;
+    }
+
+    void Reset(World& world) {
+        time_ = 0;
+        burning_.clear();
+        changed_.clear();
+        state_.Attach(world, terrain_.Size());
+    }
+
+    // Chance per step that fire spreads from a tile burning for 1 / inverseBurnTime steps to its neighbor. It gives the total chance of
+    // FireSpreadSimulation over the burn time, the closed form of GetStepProbability.
+    static float GetSpreadProbability(float inverseBurnTime, float sourceHeight, VegetationType targetVegetation, float targetHeight,
+                                      uint8_t targetMoisture, float windFactor) {
+        float combined = (VegetationFactors[static_cast<int>(targetVegetation)] + Slope::Factor(sourceHeight, targetHeight)) / 2;
+        float total = combined * GetMoistureFactor(targetMoisture) * windFactor;
+        return 1.0f - std::pow(1.0f - std::min(total, 1.0f), inverseBurnTime);
+    }
+
+    static int GetBurnTime(VegetationType vegetation) {
+        return BurnTimes[static_cast<int>(vegetation)];
+    }
+
+private:
+    void BuildProbabilities(float windSpeed, int windDirection) {
+        tableWindSpeed_ = windSpeed;
+        tableWindDirection_ = windDirection;
+
+        float windFactors[Neighborhood::Count];
+        for (int k = 0; k < Neighborhood::Count; ++k) {
+            windFactors[k] = Wind::Factor(windSpeed, windDirection, Neighborhood::DeltaX[k], Neighborhood::DeltaY[k]);
+        }
+
+        const int width = terrain_.width;
+        const int depth = terrain_.depth;
+        probabilities_.assign(terrain_.Size() * Neighborhood::Count, 0.0f);
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < depth; ++y) {
+                std::size_t tile = static_cast<std::size_t>(x) * depth + y;
+                float inverseBurnTime = 1.0f / BurnTimes[static_cast<int>(terrain_.vegetation[tile])];
+                for (int k = 0; k < Neighborhood::Count; ++k) {
+                    const int nx = x + Neighborhood::DeltaX[k];
+                    const int ny = y + Neighborhood::DeltaY[k];
+                    if (nx < 0 || nx >= width || ny < 0 || ny >= depth) {
+                        continue;
+                    }
+                    std::size_t neighbor = static_cast<std::size_t>(nx) * depth + ny;
+                    probabilities_[tile * Neighborhood::Count + k] =
+                            GetSpreadProbability(inverseBurnTime, terrain_.height[tile], terrain_.vegetation[neighbor], terrain_.height[neighbor],
+                                                 terrain_.moisture[neighbor], windFactors[k]);
+                }
+            }
+        }
+    }
+
+    static float GetMoistureFactor(int moisture) {
+        return moisture == 100 ? 0.0f : moisture > 85 ? 0.5f : moisture > 65 ? 0.7f : 0.88f;
+    }
+};
+
+
+
+// Simulation adapter of a SpreadKernel, so MainLogic and the scenario runner can use it like any other simulation. Only the adapter's
+// methods are virtual, the kernel's step runs without any indirection.
+template <class Neighborhood, class Wind, class Slope, class Rng, class State>
+class PolicySimulation : public Simulation {
+    World& world_;
+    SpreadKernel<Neighborhood, Wind, Slope, Rng, State> kernel_;
+    std::vector<Tile*> prohibitedTiles_;
+    std::vector<Tile*> lastChangedTiles_;
+
+public:
+    PolicySimulation(World& world, uint32_t seed) : world_(world), kernel_(world.GetTerrainPlanes(), seed) {
+        InitWorldParameters();
+        kernel_.Reset(world_);
+        for (auto& row : world_.grid) {
+            for (auto* tile : row) {
+                if (tile != nullptr && tile->GetMoisture() == 100) {
+                    prohibitedTiles_.push_back(tile);
+                }
+            }
+        }
+    }
+
+    // Adds the same global and per-tile parameters as FireSpreadSimulation, so exporters, recorders and the visualizer work unchanged.
+    void InitWorldParameters() {
+        size_t totalTiles = world_.GetWidth() * world_.GetDepth();
+        world_.AddParameter("windSpeed", std::make_shared<TypedParameter<float>>(5.0f, 0.0f, 50.0f));
+        world_.AddParameter("windDirection", std::make_shared<TypedParameter<int>>(0, 0, 360));
+        world_.AddVectorParameter<bool>("isBurning", totalTiles, false, false, true);
+        world_.AddVectorParameter<bool>("hasBurned", totalTiles, false, false, true);
+        world_.AddVectorParameter<int>("burningFor", totalTiles, 0, 0, std::numeric_limits<int>::max());
+        world_.AddVectorParameter<int>("ignitionTime", totalTiles, -1, -1, std::numeric_limits<int>::max());
+    }
+
+    void Initialize(std::vector<Tile*>& startingTiles) override {
+        std::vector<uint32_t> tiles;
+        for (auto* tile : startingTiles) {
+            tiles.push_back(static_cast<uint32_t>(world_.GetTileIndex(tile)));
+        }
+        kernel_.Ignite(tiles);
+        events_.Clear();
+        MirrorChanges();
+    }
+
+    void Update() override {
+        kernel_.Step(world_.GetParameter<float>("windSpeed")->GetValue(), world_.GetParameter<int>("windDirection")->GetValue());
+        MirrorChanges();
+    }
+
+    bool HasEnded() const override {
+        return kernel_.HasEnded();
+    }
+
+    void Reset() override {
+        world_.ResetParameters();
+        for (auto& row : world_.grid) {
+            for (auto& tile : row) {
+                tile->ResetParameters();
+            }
+        }
+        kernel_.Reset(world_);
+        lastChangedTiles_.clear();
+        events_.Clear();
+    }
+
+    const std::vector<Tile*>& GetLastChangedTiles() const override {
+        return lastChangedTiles_;
+    }
+
+    std::vector<Tile*> GetProhibitedTiles() const override {
+        return prohibitedTiles_;
+    }
+
+    std::unordered_map<int, sf::Color> GetChangedTileColors() const override {
+        std::unordered_map<int, sf::Color> tileColors;
+        for (auto tileIndex : kernel_.GetChanged()) {
+            tileColors[static_cast<int>(tileIndex)] = FireSpreadSimulation::GetTileStateColor(kernel_.GetState().Get(tileIndex));
+        }
+        return tileColors;
+    }
+
+private:
+    // Copies the changed tiles to the world's parameter planes, unless the kernel already works on them, and publishes them to the observers.
+    void MirrorChanges() {
+        lastChangedTiles_.clear();
+        const auto& state = kernel_.GetState();
+        int depth = world_.GetDepth();
+        for (auto tileIndex : kernel_.GetChanged()) {
+            lastChangedTiles_.push_back(world_.grid[tileIndex / depth][tileIndex % depth]);
+            if (state.Get(tileIndex) == TileState::Burning) {
+                events_.Ignite(tileIndex);
+            } else {
+                events_.BurnOut(tileIndex);
+            }
+        }
+        if constexpr (!State::WritesWorld) {
+            auto isBurningParam = world_.GetVectorParameter<bool>("isBurning");
+            auto hasBurnedParam = world_.GetVectorParameter<bool>("hasBurned");
+            auto burningForParam = world_.GetVectorParameter<int>("burningFor");
+            auto ignitionTimeParam = world_.GetVectorParameter<int>("ignitionTime");
+            for (auto tileIndex : kernel_.GetChanged()) {
+                TileState tileState = state.Get(tileIndex);
+                isBurningParam->SetValue(tileIndex, tileState == TileState::Burning);
+                hasBurnedParam->SetValue(tileIndex, tileState == TileState::Burned);
+                burningForParam->SetValue(tileIndex, state.GetBurningFor(tileIndex));
+                ignitionTimeParam->SetValue(tileIndex, state.GetIgnitionTime(tileIndex));
+            }
+        }
+        events_.Publish(kernel_.GetTime());
+    }
+};
+
+// Default specialization, matching the rules of FireSpreadSimulation.
+using FastSpreadSimulation = PolicySimulation<MooreNeighborhood, DirectionalWind, StepSlope, CounterRng, CompactState>;
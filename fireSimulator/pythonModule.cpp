@@ -0,0 +1,197 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <mutex>
+#include <unordered_set>
+
+#include "simulation.h"
+#include "worldGenerator.h"
+
+namespace py = pybind11;
+
+// Python module "firesim": the world generator, worlds and the spread simulation, with terrain and state planes exposed as NumPy arrays
+// that view the C++ buffers instead of copying them. Generation, updates and ensembles release the GIL.
+
+// Read-only 2D array (width x depth, tile index order) over data kept alive by owner for as long as the array or a view of it exists.
+template <typename T>
+static py::array_t<T> PlaneView(const T* data, int width, int depth, std::shared_ptr<void> owner) {
+    py::capsule base(new std::shared_ptr<void>(std::move(owner)), [](void* pointer) { delete static_cast<std::shared_ptr<void>*>(pointer); });
+    py::array_t<T> array({width, depth}, data, base);
+    array.attr("setflags")(py::arg("write") = false);
+    return array;
+}
+
+// View of a per-tile parameter of the world. The array keeps the parameter alive, even if the world replaces or drops it.
+template <typename T>
+static py::array StateView(World& world, const std::string& name) {
+    auto parameter = world.GetVectorParameter<T>(name);
+    if (!parameter) {
+        throw py::key_error("World has no tile parameter " + name + ", it is added by the simulation");
+    }
+    using Storage = typename TypedVectorParameter<T>::Storage;
+    using Element = typename std::conditional<std::is_same<T, bool>::value, bool, Storage>::type; // Flags are 0/1 bytes, i.e. NumPy bools
+    return PlaneView(reinterpret_cast<const Element*>(parameter->Data()), world.GetWidth(), world.GetDepth(), parameter);
+}
+
+// Terrain arrays of a world, flattened once per world object and cached in its __dict__ (the terrain does not change after generation).
+static py::dict TerrainViews(py::object self) {
+    py::dict attributes = self.attr("__dict__");
+    if (attributes.contains("_terrain")) {
+        return attributes["_terrain"];
+    }
+    World& world = self.cast<World&>();
+    auto planes = std::make_shared<TerrainPlanes>(world.GetTerrainPlanes());
+    static_assert(sizeof(VegetationType) == sizeof(int32_t), "Vegetation is exposed as int32");
+    py::dict terrain;
+    terrain["height"] = PlaneView(planes->height.data(), planes->width, planes->depth, planes);
+    terrain["moisture"] = PlaneView(planes->moisture.data(), planes->width, planes->depth, planes);
+    terrain["vegetation"] = PlaneView(reinterpret_cast<const int32_t*>(planes->vegetation.data()), planes->width, planes->depth, planes);
+    attributes["_terrain"] = terrain;
+    return terrain;
+}
+
+// Starting tiles from (x, y) pairs, leaving out the tiles the simulation prohibits (water), as the scenario runner does.
+static std::vector<Tile*> GetStartingTiles(World& world, const Simulation& simulation, const std::vector<std::pair<int, int>>& ignitions) {
+    auto prohibited = simulation.GetProhibitedTiles();
+    std::unordered_set<Tile*> prohibitedTiles(prohibited.begin(), prohibited.end());
+    std::vector<Tile*> startingTiles;
+    for (const auto& [x, y] : ignitions) {
+        Tile* tile = world.GetTileAt(x, y);
+        if (prohibitedTiles.count(tile) == 0) {
+            startingTiles.push_back(tile);
+        }
+    }
+    return startingTiles;
+}
+
+// Runs one spread simulation per seed on copies of the world's terrain, in parallel on the shared task scheduler. Returns the burned tile
+// count and step count of every member and the share of members in which each tile burned.
+static py::dict RunEnsemble(World& world, const std::vector<std::pair<int, int>>& ignitions, const std::vector<uint32_t>& seeds, int maxSteps,
+                            float windSpeed, int windDirection) {
+    auto burnedTiles = std::make_shared<std::vector<int64_t>>(seeds.size());
+    auto steps = std::make_shared<std::vector<int32_t>>(seeds.size());
+    auto burnProbability = std::make_shared<std::vector<float>>(static_cast<std::size_t>(world.GetWidth()) * world.GetDepth(), 0.0f);
+    {
+        py::gil_scoped_release release;
+        std::mutex mergeMutex;
+        TaskScheduler::Shared().ParallelFor(0, seeds.size(), 1, [&](std::size_t from, std::size_t to) {
+            std::vector<uint32_t> burnedCounts(burnProbability->size(), 0);
+            for (std::size_t member = from; member < to; ++member) {
+                auto copy = world.CopyTerrain();
+                FireSpreadSimulation simulation(*copy, seeds[member]);
+                copy->GetParameter<float>("windSpeed")->SetValue(windSpeed);
+                copy->GetParameter<int>("windDirection")->SetValue(windDirection);
+                auto startingTiles = GetStartingTiles(*copy, simulation, ignitions);
+                simulation.Initialize(startingTiles);
+                int step = 0;
+                for (; step < maxSteps && !simulation.HasEnded(); ++step) {
+                    simulation.Update();
+                }
+
+                auto isBurning = copy->GetVectorParameter<bool>("isBurning");
+                auto hasBurned = copy->GetVectorParameter<bool>("hasBurned");
+                int64_t burned = 0;
+                for (std::size_t tile = 0; tile < burnedCounts.size(); ++tile) {
+                    bool reached = isBurning->Data()[tile] || hasBurned->Data()[tile];
+                    burnedCounts[tile] += reached;
+                    burned += reached;
+                }
+                (*burnedTiles)[member] = burned;
+                (*steps)[member] = step;
+            }
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            for (std::size_t tile = 0; tile < burnedCounts.size(); ++tile) {
+                (*burnProbability)[tile] += static_cast<float>(burnedCounts[tile]);
+            }
+        });
+        float members = static_cast<float>(std::max<std::size_t>(1, seeds.size()));
+        for (float& probability : *burnProbability) {
+            probability /= members;
+        }
+    }
+
+    py::dict result;
+    result["burned_tiles"] = py::array_t<int64_t>(burnedTiles->size(), burnedTiles->data(),
+                                                  py::capsule(new std::shared_ptr<void>(burnedTiles), [](void* pointer) { delete static_cast<std::shared_ptr<void>*>(pointer); }));
+    result["steps"] = py::array_t<int32_t>(steps->size(), steps->data(),
+                                           py::capsule(new std::shared_ptr<void>(steps), [](void* pointer) { delete static_cast<std::shared_ptr<void>*>(pointer); }));
+    result["burn_probability"] = PlaneView(burnProbability->data(), world.GetWidth(), world.GetDepth(), burnProbability);
+    return result;
+}
+
+PYBIND11_MODULE(firesim, module) {
+    module.doc() = "Fire spread simulation engine with zero-copy NumPy views of terrain and state";
+
+    py::class_<World, std::shared_ptr<World>>(module, "World", py::dynamic_attr())
+            .def_property_readonly("width", &World::GetWidth)
+            .def_property_readonly("depth", &World::GetDepth)
+            .def_property_readonly("terrain", &TerrainViews, "Read-only height (float32), moisture (uint8, 100 is water) and vegetation (int32) arrays")
+            .def("state", [](World& world, const std::string& name) -> py::array {
+                if (name == "isBurning" || name == "hasBurned") {
+                    return StateView<bool>(world, name);
+                }
+                if (name == "burningFor" || name == "burnTime" || name == "ignitionTime" || name == "moistureDelta") {
+                    return StateView<int>(world, name);
+                }
+                if (name == "fuelFactor") {
+                    return StateView<float>(world, name);
+                }
+                throw py::key_error("Unknown tile parameter " + name);
+            }, py::arg("name"), "Read-only view of a per-tile parameter, e.g. \"isBurning\" or \"ignitionTime\"; it follows the simulation's updates")
+            .def_property("wind_speed", [](World& world) {
+                auto parameter = world.GetParameter<float>("windSpeed");
+                return parameter ? parameter->GetValue() : 0.0f;
+            }, [](World& world, float value) {
+                auto parameter = world.GetParameter<float>("windSpeed");
+                if (!parameter) {
+                    throw py::key_error("World has no wind, it is added by the simulation");
+                }
+                parameter->SetValue(value);
+            })
+            .def_property("wind_direction", [](World& world) {
+                auto parameter = world.GetParameter<int>("windDirection");
+                return parameter ? parameter->GetValue() : 0;
+            }, [](World& world, int value) {
+                auto parameter = world.GetParameter<int>("windDirection");
+                if (!parameter) {
+                    throw py::key_error("World has no wind, it is added by the simulation");
+                }
+                parameter->SetValue(value);
+            })
+            .def("copy_terrain", &World::CopyTerrain, py::call_guard<py::gil_scoped_release>(), "New world with the same terrain and no parameters");
+
+    py::class_<WorldGenerator>(module, "WorldGenerator")
+            .def(py::init<int, int, float, int>(), py::arg("width"), py::arg("depth"), py::arg("lake_threshold") = 0.15f, py::arg("rivers") = 3)
+            .def(py::init<int, int, float, int, unsigned int>(), py::arg("width"), py::arg("depth"), py::arg("lake_threshold"), py::arg("rivers"),
+                 py::arg("seed"))
+            .def("generate", [](WorldGenerator& generator) {
+                generator.scheduler = &TaskScheduler::Shared();
+                return generator.Generate();
+            }, py::call_guard<py::gil_scoped_release>());
+
+    py::class_<FireSpreadSimulation>(module, "FireSpreadSimulation")
+            .def(py::init([](World& world, uint32_t seed, bool parallel) {
+                auto simulation = std::make_unique<FireSpreadSimulation>(world, seed);
+                simulation->SetScheduler(parallel ? &TaskScheduler::Shared() : nullptr);
+                return simulation;
+            }), py::arg("world"), py::arg("seed") = 0, py::arg("parallel") = true, py::keep_alive<1, 2>())
+            .def("initialize", [](FireSpreadSimulation& simulation, const std::vector<std::pair<int, int>>& ignitions) {
+                auto startingTiles = GetStartingTiles(simulation.GetWorld(), simulation, ignitions);
+                simulation.Initialize(startingTiles);
+            }, py::arg("ignitions"), "Sets the (x, y) tiles burning, water tiles are left out")
+            .def("update", &FireSpreadSimulation::Update, py::call_guard<py::gil_scoped_release>())
+            .def("run", [](FireSpreadSimulation& simulation, int maxSteps) {
+                int steps = 0;
+                for (; steps < maxSteps && !simulation.HasEnded(); ++steps) {
+                    simulation.Update();
+                }
+                return steps;
+            }, py::arg("max_steps"), py::call_guard<py::gil_scoped_release>(), "Updates until the fire is out or max_steps passed, returns the steps run")
+            .def("has_ended", &FireSpreadSimulation::HasEnded)
+            .def("reset", &FireSpreadSimulation::Reset);
+
+    module.def("run_ensemble", &RunEnsemble, py::arg("world"), py::arg("ignitions"), py::arg("seeds"), py::arg("max_steps") = 10000,
+               py::arg("wind_speed") = 5.0f, py::arg("wind_direction") = 0,
+               "Runs one spread simulation per seed on copies of the world in parallel, returns burned_tiles, steps and burn_probability arrays");
+}
@@ -0,0 +1,32 @@
+# Smoke test of the firesim module: state arrays view the simulation's buffers, so arrays fetched once follow update() without a copy.
+# Usage: PYTHONPATH=<directory of the built module> python3 pythonSmokeTest.py (or the firesimSmokeTest CMake target)
+import numpy as np
+
+import firesim
+
+world = firesim.WorldGenerator(64, 64, 0.0, 0, 3).generate()
+simulation = firesim.FireSpreadSimulation(world, seed=1, parallel=False)
+world.wind_speed = 10.0
+simulation.initialize([(32, 32)])
+
+burning = world.state("isBurning")
+burned = world.state("hasBurned")
+assert burning.dtype == np.bool_ and burning.shape == (world.width, world.depth)
+assert not burning.flags.writeable and not burning.flags.owndata
+assert burning.sum() == 1 and burned.sum() == 0
+
+address = burning.__array_interface__["data"][0]
+for _ in range(20):
+    simulation.update()
+
+# The arrays fetched before the updates show the new state, and fetching again returns a view of the same buffer
+current = world.state("isBurning")
+assert current.__array_interface__["data"][0] == address
+assert np.array_equal(burning, current)
+assert np.array_equal(burned, world.state("hasBurned"))
+assert (burning | burned).sum() > 1, "the fire did not spread in 20 steps"
+
+terrain = world.terrain
+assert terrain["moisture"].shape == (world.width, world.depth)
+assert not np.any(burned & (terrain["moisture"] == 100)), "water burned"
+print("firesim smoke test passed")
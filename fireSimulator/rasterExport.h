@@ -0,0 +1,184 @@
+#pragma once
+#include <charconv>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <ostream>
+
+#include "binaryIO.h"
+#include "simulation.h"
+
+// Per-tile results that can be exported as a raster.
+enum class RasterLayer : uint8_t {
+    FinalState = 0,   // TileState code: 0 unburned, 1 burning, 2 burned
+    IgnitionTime = 1, // Step in which the tile caught fire, -1 (no data) if it never did
+    BurnDuration = 2  // Number of steps the tile has burned
+};
+
+// Raster read back from the run-length encoded format, values in the same row-major order as the world's tile indices.
+struct Raster {
+    RasterLayer layer;
+    int width;
+    int depth;
+    std::vector<int32_t> values;
+};
+
+// Exports the result of a fire simulation ("isBurning", "hasBurned", "ignitionTime" and "burningFor" parameters of the world) as rasters
+// for GIS tools. Every export is a single streaming pass over the state planes, holding at most one row of output in memory.
+// Rows of the raster are the world's width positions (x) and columns its depth positions (y), as shown by the visualizer.
+class RasterExporter {
+    World& world_;
+
+    struct Planes {
+        const uint8_t* isBurning;
+        const uint8_t* hasBurned;
+        const int* ignitionTime;
+        const int* burningFor;
+    };
+
+public:
+    static constexpr int NoData = -1;
+    static constexpr uint32_t RunLengthMagic = 0x4c525346; // "FSRL"
+    static constexpr uint32_t RunLengthVersion = 1;
+
+    explicit RasterExporter(World& world) : world_(world) {}
+
+    // Writes the layer as an ESRI ASCII grid. The lower left corner and cell size place the raster in the target coordinate system.
+    void WriteAsciiGrid(RasterLayer layer, std::ostream& out, double cellSize = 1.0, double xllCorner = 0.0, double yllCorner = 0.0) const {
+        Planes planes = GetPlanes();
+        int width = world_.GetWidth();
+        int depth = world_.GetDepth();
+
+        out << "ncols " << depth << "\n"
+            << "nrows " << width << "\n"
+            << "xllcorner " << xllCorner << "\n"
+            << "yllcorner " << yllCorner << "\n"
+            << "cellsize " << cellSize << "\n"
+            << "NODATA_value " << NoData << "\n";
+
+        std::vector<char> row(static_cast<std::size_t>(depth) * 12 + 1);
+        for (int x = 0; x < width; ++x) {
+            char* position = row.data();
+            char* end = row.data() + row.size();
+            std::size_t rowStart = static_cast<std::size_t>(x) * depth;
+            for (int y = 0; y < depth; ++y) {
+                position = std::to_chars(position, end, GetValue(layer, planes, rowStart + y)).ptr;
+                *position++ = y + 1 < depth ? ' ' : '\n';
+            }
+            out.write(row.data(), position - row.data());
+        }
+    }
+
+    // Writes the layer in a compact binary format: a small header followed by (run length, value) pairs as variable-length integers,
+    // runs continuing across rows. Large mostly-unburned rasters shrink to a few bytes per fire edge.
+    void WriteRunLength(RasterLayer layer, std::ostream& out) const {
+        Planes planes = GetPlanes();
+        std::size_t totalTiles = static_cast<std::size_t>(world_.GetWidth()) * world_.GetDepth();
+
+        BinaryWriter writer;
+        writer.Write<uint32_t>(RunLengthMagic);
+        writer.Write<uint32_t>(RunLengthVersion);
+        writer.Write<uint8_t>(static_cast<uint8_t>(layer));
+        writer.Write<int32_t>(world_.GetWidth());
+        writer.Write<int32_t>(world_.GetDepth());
+
+        const std::size_t flushSize = 1 << 16;
+        std::size_t i = 0;
+        while (i < totalTiles) {
+            int32_t value = GetValue(layer, planes, i);
+            std::size_t run = 1;
+            while (i + run < totalTiles && GetValue(layer, planes, i + run) == value) {
+                ++run;
+            }
+            writer.WriteVarUInt(run);
+            writer.WriteVarUInt(ZigZag(value));
+            i += run;
+
+            if (writer.Size() >= flushSize) {
+                Flush(writer, out);
+            }
+        }
+        Flush(writer, out);
+    }
+
+    void WriteAsciiGrid(RasterLayer layer, const std::string& path, double cellSize = 1.0, double xllCorner = 0.0, double yllCorner = 0.0) const {
+        std::ofstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot write raster " + path);
+        }
+        WriteAsciiGrid(layer, file, cellSize, xllCorner, yllCorner);
+    }
+
+    void WriteRunLength(RasterLayer layer, const std::string& path) const {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot write raster " + path);
+        }
+        WriteRunLength(layer, file);
+    }
+
+    // Reads a raster written by WriteRunLength.
+    static Raster ReadRunLength(std::istream& in) {
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        BinaryReader reader(data);
+        if (reader.Read<uint32_t>() != RunLengthMagic || reader.Read<uint32_t>() != RunLengthVersion) {
+            throw std::runtime_error("Not a run-length encoded fire raster");
+        }
+
+        Raster raster;
+        raster.layer = static_cast<RasterLayer>(reader.Read<uint8_t>());
+        raster.width = reader.Read<int32_t>();
+        raster.depth = reader.Read<int32_t>();
+        std::size_t totalTiles = static_cast<std::size_t>(raster.width) * raster.depth;
+        raster.values.reserve(totalTiles);
+        while (raster.values.size() < totalTiles) {
+            std::size_t run = reader.ReadVarUInt();
+            int32_t value = UnZigZag(reader.ReadVarUInt());
+            if (run == 0 || run > totalTiles - raster.values.size()) {
+                throw std::runtime_error("Malformed run-length raster");
+            }
+            raster.values.insert(raster.values.end(), run, value);
+        }
+        return raster;
+    }
+
+private:
+    Planes GetPlanes() const {
+        auto isBurningParam = world_.GetVectorParameter<bool>("isBurning");
+        auto hasBurnedParam = world_.GetVectorParameter<bool>("hasBurned");
+        auto ignitionTimeParam = world_.GetVectorParameter<int>("ignitionTime");
+        auto burningForParam = world_.GetVectorParameter<int>("burningFor");
+        if (!isBurningParam || !hasBurnedParam || !ignitionTimeParam || !burningForParam) {
+            throw std::runtime_error("World has no fire simulation state to export");
+        }
+        return {isBurningParam->Data(), hasBurnedParam->Data(), ignitionTimeParam->Data(), burningForParam->Data()};
+    }
+
+    static int32_t GetValue(RasterLayer layer, const Planes& planes, std::size_t index) {
+        switch (layer) {
+            case RasterLayer::FinalState:
+                return planes.isBurning[index] ? static_cast<int32_t>(TileState::Burning)
+                     : planes.hasBurned[index] ? static_cast<int32_t>(TileState::Burned) : static_cast<int32_t>(TileState::Unburned);
+            case RasterLayer::IgnitionTime:
+                return planes.ignitionTime[index] >= 0 ? planes.ignitionTime[index] : NoData;
+            case RasterLayer::BurnDuration:
+                return planes.ignitionTime[index] >= 0 ? planes.burningFor[index] : 0;
+        }
+        return NoData;
+    }
+
+    static uint32_t ZigZag(int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    static int32_t UnZigZag(uint64_t value) {
+        uint32_t zigZag = static_cast<uint32_t>(value);
+        return static_cast<int32_t>((zigZag >> 1) ^ (0u - (zigZag & 1u)));
+    }
+
+    static void Flush(BinaryWriter& writer, std::ostream& out) {
+        const auto& buffer = writer.GetBuffer();
+        out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        writer.Clear();
+    }
+};
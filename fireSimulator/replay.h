@@ -0,0 +1,305 @@
+#pragma once
+#include "binaryIO.h"
+#include "simulation.h"
+
+// Records a run of a fire simulation as a stream of per-step tile changes (deltas) plus periodic compressed keyframes
+// of the complete fire state. Keyframes let ReplayPlayer reach any recorded step without re-simulating from step 0.
+class SimulationRecorder : public SimulationObserver {
+public:
+    // Single recorded change of one tile. burningFor is 0 for ignitions and the total burn duration for burnouts, which allows stepping backwards.
+    struct Change {
+        uint32_t tileIndex;
+        TileState state;
+        uint16_t burningFor;
+    };
+
+private:
+    World& world_;
+    int keyframeInterval_;
+    std::size_t tileCount_;
+
+    std::vector<Change> changes_; // Changes of all steps, step after step
+    std::vector<std::size_t> stepOffsets_; // Changes of step s are changes_[stepOffsets_[s]] .. changes_[stepOffsets_[s + 1] - 1]
+    std::vector<std::vector<uint8_t>> keyframes_; // Keyframe k holds the state after step k * keyframeInterval_
+
+    std::vector<TileState> states_; // Fire state at the last recorded step
+    std::vector<int> ignitionSteps_; // Step in which each burning tile ignited
+
+public:
+    explicit SimulationRecorder(World& world, int keyframeInterval = 64)
+            : world_(world), keyframeInterval_(std::max(1, keyframeInterval)),
+              tileCount_(static_cast<std::size_t>(world.GetWidth()) * world.GetDepth()) {
+        Clear();
+    }
+
+    // Starts a new recording from the initial state of the simulation (step 0), e.g. right after Simulation::Initialize.
+    void Begin(const std::vector<Tile*>& initialTiles) {
+        Clear();
+        RecordStep(initialTiles);
+    }
+
+    // Appends the changes of the next step. New states are read from the "isBurning" and "hasBurned" parameters of the world.
+    void RecordStep(const std::vector<Tile*>& changedTiles) {
+        auto isBurningParam = world_.GetVectorParameter<bool>("isBurning");
+        auto hasBurnedParam = world_.GetVectorParameter<bool>("hasBurned");
+        int step = GetStepCount();
+
+        for (auto* tile : changedTiles) {
+            std::size_t tileIndex = world_.GetTileIndex(tile);
+            TileState state = isBurningParam->GetValue(tileIndex) ? TileState::Burning
+                            : hasBurnedParam->GetValue(tileIndex) ? TileState::Burned : TileState::Unburned;
+            RecordChange(static_cast<uint32_t>(tileIndex), state, step);
+        }
+        EndStep(step);
+    }
+
+    // Records the changes a simulation publishes, see Simulation::Subscribe. Step 0 (Simulation::Initialize) starts a new recording.
+    void OnStepCompleted(const StepChanges& changes) override {
+        if (changes.step == 0) {
+            Clear();
+        }
+        int step = GetStepCount();
+        for (std::size_t i = 0; i < changes.tiles.size(); ++i) {
+            RecordChange(changes.tiles[i], changes.states[i], step);
+        }
+        EndStep(step);
+    }
+
+    // Number of recorded steps, including the initial step 0.
+    int GetStepCount() const {
+        return static_cast<int>(stepOffsets_.size()) - 1;
+    }
+
+    int GetKeyframeInterval() const { return keyframeInterval_; }
+    std::size_t GetTileCount() const { return tileCount_; }
+
+    // Index range of the changes recorded in the given step, to be used with GetChange.
+    std::pair<std::size_t, std::size_t> GetChangeRange(int step) const {
+        return {stepOffsets_[step], stepOffsets_[step + 1]};
+    }
+
+    const Change& GetChange(std::size_t index) const {
+        return changes_[index];
+    }
+
+    // Total size of the recording in bytes, useful to tune the keyframe interval.
+    std::size_t GetMemoryUsage() const {
+        std::size_t size = changes_.size() * sizeof(Change) + stepOffsets_.size() * sizeof(std::size_t);
+        for (const auto& keyframe : keyframes_) {
+            size += keyframe.size();
+        }
+        return size;
+    }
+
+    // Decodes the keyframe nearest before the given step. Returns the step of that keyframe.
+    int DecodeKeyframe(int step, std::vector<TileState>& states, std::vector<uint16_t>& burningFor) const {
+        std::size_t keyframeIndex = std::min(static_cast<std::size_t>(step / keyframeInterval_), keyframes_.size() - 1);
+        BinaryReader reader(keyframes_[keyframeIndex]);
+
+        std::size_t wordCount = (tileCount_ + 63) / 64;
+        std::vector<uint64_t> burningBits(wordCount), burnedBits(wordCount);
+        ReadRunLength(reader, burningBits.data(), wordCount);
+        ReadRunLength(reader, burnedBits.data(), wordCount);
+
+        states.resize(tileCount_);
+        burningFor.resize(tileCount_);
+        ReadRunLength(reader, burningFor.data(), tileCount_);
+        for (std::size_t i = 0; i < tileCount_; ++i) {
+            states[i] = GetPackedBit(burningBits, i) ? TileState::Burning
+                      : GetPackedBit(burnedBits, i) ? TileState::Burned : TileState::Unburned;
+        }
+        return static_cast<int>(keyframeIndex) * keyframeInterval_;
+    }
+
+private:
+    void RecordChange(uint32_t tileIndex, TileState state, int step) {
+        if (state == states_[tileIndex]) {
+            return; // Reported, but nothing to replay
+        }
+
+        if (state == TileState::Burned && states_[tileIndex] == TileState::Unburned) {
+            RecordChange(tileIndex, TileState::Burning, step); // Ignited and burned out within the step, recorded as both so undo reaches unburned
+        }
+
+        uint16_t burningFor = 0;
+        if (state == TileState::Burning) {
+            ignitionSteps_[tileIndex] = step;
+        } else if (state == TileState::Burned) {
+            burningFor = static_cast<uint16_t>(std::min(step - ignitionSteps_[tileIndex], 0xffff));
+        }
+        states_[tileIndex] = state;
+        changes_.push_back({tileIndex, state, burningFor});
+    }
+
+    void EndStep(int step) {
+        stepOffsets_.push_back(changes_.size());
+        if (step % keyframeInterval_ == 0) {
+            keyframes_.push_back(EncodeKeyframe(step));
+        }
+    }
+
+    void Clear() {
+        changes_.clear();
+        stepOffsets_.assign(1, 0);
+        keyframes_.clear();
+        states_.assign(tileCount_, TileState::Unburned);
+        ignitionSteps_.assign(tileCount_, 0);
+    }
+
+    // Keyframe layout: run-length encoded burning and burned bit planes, followed by the run-length encoded burningFor plane.
+    std::vector<uint8_t> EncodeKeyframe(int step) const {
+        auto burningBits = PackBits(tileCount_, [&](std::size_t i) { return states_[i] == TileState::Burning; });
+        auto burnedBits = PackBits(tileCount_, [&](std::size_t i) { return states_[i] == TileState::Burned; });
+
+        std::vector<uint16_t> burningFor(tileCount_, 0);
+        for (std::size_t i = 0; i < tileCount_; ++i) {
+            if (states_[i] == TileState::Burning) {
+                burningFor[i] = static_cast<uint16_t>(std::min(step - ignitionSteps_[i], 0xffff));
+            }
+        }
+
+        BinaryWriter writer;
+        WriteRunLength(writer, burningBits.data(), burningBits.size());
+        WriteRunLength(writer, burnedBits.data(), burnedBits.size());
+        WriteRunLength(writer, burningFor.data(), burningFor.size());
+        return writer.TakeBuffer();
+    }
+};
+
+
+
+// Plays back a recording made by SimulationRecorder. Any step can be reached forwards or backwards, with work bounded
+// by the keyframe interval: far jumps start from the nearest keyframe, short ones replay (or undo) the deltas.
+class ReplayPlayer {
+    const SimulationRecorder& recording_;
+    int currentStep_ = -1;
+
+    std::vector<TileState> states_;
+    std::vector<int> ignitionSteps_;
+
+    std::vector<uint32_t> touchedTiles_; // Tiles changed by the last seek
+    std::vector<bool> isTouched_;
+
+public:
+    explicit ReplayPlayer(const SimulationRecorder& recording)
+            : recording_(recording), states_(recording.GetTileCount(), TileState::Unburned),
+              ignitionSteps_(recording.GetTileCount(), -1), isTouched_(recording.GetTileCount(), false) {}
+
+    // Moves the playback to the given step, clamped to the recorded range.
+    void Seek(int step) {
+        ClearTouched();
+        if (recording_.GetStepCount() == 0) {
+            return;
+        }
+        step = std::max(0, std::min(step, recording_.GetStepCount() - 1));
+
+        if (currentStep_ < 0 || std::abs(step - currentStep_) > recording_.GetKeyframeInterval()) {
+            LoadKeyframe(step);
+        }
+        while (currentStep_ < step) {
+            ApplyStep(currentStep_ + 1);
+        }
+        while (currentStep_ > step) {
+            UndoStep(currentStep_);
+        }
+    }
+
+    // Plays the given number of steps forwards (positive) or backwards (negative), which allows playback at any speed.
+    void Advance(int steps) {
+        Seek(currentStep_ + steps);
+    }
+
+    int GetCurrentStep() const { return currentStep_; }
+    bool IsAtEnd() const { return currentStep_ == recording_.GetStepCount() - 1; }
+
+    TileState GetTileState(std::size_t tileIndex) const {
+        return states_[tileIndex];
+    }
+
+    // Number of steps the tile has been burning at the current step, the replayed counterpart of the "burningFor" parameter.
+    int GetBurningFor(std::size_t tileIndex) const {
+        return states_[tileIndex] == TileState::Burning ? currentStep_ - ignitionSteps_[tileIndex] : 0;
+    }
+
+    // Colors of the burning and burned tiles changed by the last seek, in the format of Visualizer::updateTileColors.
+    std::unordered_map<int, sf::Color> GetChangedTileColors() const {
+        std::unordered_map<int, sf::Color> tileColors;
+        for (auto tileIndex : touchedTiles_) {
+            if (states_[tileIndex] != TileState::Unburned) {
+                tileColors[static_cast<int>(tileIndex)] = FireSpreadSimulation::GetTileStateColor(states_[tileIndex]);
+            }
+        }
+        return tileColors;
+    }
+
+    // Tiles that went back to unburned in the last seek, so their simulation colors have to be removed.
+    std::vector<int> GetRestoredTiles() const {
+        std::vector<int> restored;
+        for (auto tileIndex : touchedTiles_) {
+            if (states_[tileIndex] == TileState::Unburned) {
+                restored.push_back(static_cast<int>(tileIndex));
+            }
+        }
+        return restored;
+    }
+
+private:
+    void Touch(uint32_t tileIndex) {
+        if (!isTouched_[tileIndex]) {
+            isTouched_[tileIndex] = true;
+            touchedTiles_.push_back(tileIndex);
+        }
+    }
+
+    void ClearTouched() {
+        for (auto tileIndex : touchedTiles_) {
+            isTouched_[tileIndex] = false;
+        }
+        touchedTiles_.clear();
+    }
+
+    void LoadKeyframe(int step) {
+        std::vector<TileState> keyframeStates;
+        std::vector<uint16_t> burningFor;
+        int keyframeStep = recording_.DecodeKeyframe(step, keyframeStates, burningFor);
+
+        for (std::size_t i = 0; i < keyframeStates.size(); ++i) {
+            if (keyframeStates[i] != states_[i]) {
+                states_[i] = keyframeStates[i];
+                Touch(static_cast<uint32_t>(i));
+            }
+            ignitionSteps_[i] = keyframeStates[i] == TileState::Burning ? keyframeStep - burningFor[i] : -1;
+        }
+        currentStep_ = keyframeStep;
+    }
+
+    void ApplyStep(int step) {
+        auto [begin, end] = recording_.GetChangeRange(step);
+        for (std::size_t i = begin; i < end; ++i) {
+            const auto& change = recording_.GetChange(i);
+            states_[change.tileIndex] = change.state;
+            if (change.state == TileState::Burning) {
+                ignitionSteps_[change.tileIndex] = step;
+            }
+            Touch(change.tileIndex);
+        }
+        currentStep_ = step;
+    }
+
+    // States only move forward (unburned -> burning -> burned), so every change can be undone without extra data.
+    void UndoStep(int step) {
+        auto [begin, end] = recording_.GetChangeRange(step);
+        for (std::size_t i = end; i > begin; --i) {
+            const auto& change = recording_.GetChange(i - 1);
+            if (change.state == TileState::Burned) {
+                states_[change.tileIndex] = TileState::Burning;
+                ignitionSteps_[change.tileIndex] = step - change.burningFor;
+            } else {
+                states_[change.tileIndex] = TileState::Unburned;
+                ignitionSteps_[change.tileIndex] = -1;
+            }
+            Touch(change.tileIndex);
+        }
+        currentStep_ = step - 1;
+    }
+};
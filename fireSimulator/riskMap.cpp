@@ -0,0 +1,80 @@
+#include <SFML/Graphics.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "ignitionOptimizer.h"
+#include "scenario.h"
+#include "worldGenerator.h"
+
+// Ignition risk maps for the worlds of a scenario file, see ignitionOptimizer.h. Ignitions, mode and outputs of the scenarios are not used,
+// the wind is the one of the first wind entry.
+// Usage: fireRiskMap <scenario file> <output directory> [--horizon=50] [--finalists=32] [--runs=16] [--stride=1] [--threads=N]
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <scenario file> <output directory> [--horizon=50] [--finalists=32] [--runs=16] [--stride=1] [--threads=N]"
+                  << std::endl;
+        return 1;
+    }
+
+    try {
+        IgnitionRiskSettings settings;
+        std::size_t threads = std::thread::hardware_concurrency();
+        for (int i = 3; i < argc; ++i) {
+            std::string option = argv[i];
+            std::size_t equals = option.find('=');
+            std::string key = option.substr(0, equals);
+            std::string value = equals == std::string::npos ? "" : option.substr(equals + 1);
+            if (key == "--horizon") {
+                settings.horizon = std::stof(value);
+            } else if (key == "--finalists") {
+                settings.finalists = std::stoi(value);
+            } else if (key == "--runs") {
+                settings.monteCarloRuns = std::stoi(value);
+            } else if (key == "--stride") {
+                settings.stride = std::stoi(value);
+            } else if (key == "--threads") {
+                threads = std::stoul(value);
+            } else {
+                throw std::runtime_error("Unknown option: " + option);
+            }
+        }
+
+        std::filesystem::path scenarioPath(argv[1]);
+        std::filesystem::create_directories(argv[2]);
+        TaskScheduler scheduler(threads);
+        for (const auto& scenario : ScenarioFile::Load(scenarioPath.string(), scenarioPath.stem().string())) {
+            auto start = std::chrono::steady_clock::now();
+            WorldGenerator generator(scenario.worldSize, scenario.worldSize, scenario.lakeThreshold, scenario.rivers, scenario.worldSeed);
+            auto world = generator.Generate();
+            world->AddParameter("windSpeed", std::make_shared<TypedParameter<float>>(scenario.wind.empty() ? 5.0f : scenario.wind[0].speed, 0.0f, 50.0f));
+            world->AddParameter("windDirection", std::make_shared<TypedParameter<int>>(scenario.wind.empty() ? 0 : scenario.wind[0].direction, 0, 360));
+
+            settings.seed = scenario.seed;
+            IgnitionOptimizer optimizer(*world, scheduler, settings);
+            IgnitionRiskMap map = optimizer.BuildRiskMap();
+
+            std::string basePath = std::string(argv[2]) + "/" + scenario.name;
+            std::ofstream grid(basePath + ".risk.asc");
+            map.WriteAsciiGrid(grid);
+
+            std::ofstream ranking(basePath + ".ranking.csv");
+            ranking << "rank,x,y,screening,monteCarlo\n";
+            for (std::size_t rank = 0; rank < map.ranking.size(); ++rank) {
+                const auto& score = map.ranking[rank];
+                uint32_t tile = map.candidateTiles[score.candidate];
+                ranking << rank + 1 << "," << tile / map.depth << "," << tile % map.depth << "," << score.screeningScore << ","
+                        << (score.monteCarloScore >= 0 ? std::to_string(score.monteCarloScore) : "") << "\n";
+            }
+
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << scenario.name << ": scored " << map.ranking.size() << " ignition tiles in " << seconds << " s" << std::endl;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
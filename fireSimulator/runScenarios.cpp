@@ -0,0 +1,38 @@
+#include <SFML/Graphics.hpp>
+
+#include <chrono>
+#include <iostream>
+
+#include "scenarioRunner.h"
+
+// Batch runner for scenario files, see scenario.h for the file format.
+// Usage: fireScenarios <scenario directory> <output directory> [threads]
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <scenario directory> <output directory> [threads]" << std::endl;
+        return 1;
+    }
+
+    std::size_t threads = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+    auto start = std::chrono::steady_clock::now();
+
+    try {
+        ScenarioRunner runner(threads);
+        auto results = runner.RunDirectory(argv[1], argv[2]);
+
+        std::size_t failed = 0;
+        for (const auto& result : results) {
+            if (!result.succeeded) {
+                failed++;
+                std::cerr << result.name << ": " << result.error << std::endl;
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Ran " << results.size() << " scenarios (" << failed << " failed) in " << seconds << " s" << std::endl;
+        return failed == 0 ? 0 : 2;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,321 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "weather.h"
+#include "spotting.h"
+#include "suppression.h"
+
+// Scenario files describe a single experiment in plain "key = value" lines, '#' starts a comment:
+//
+//   name = windy_grass            # defaults to the file name
+//   world.seed = 42               # world generation settings, same defaults as the interactive simulator
+//   world.size = 100
+//   world.lakeThreshold = 0.15
+//   world.rivers = 3
+//   ignition = 50,50; 52,50       # starting tiles as x,y pairs
+//   wind = 0:5:0; 20:15:90        # wind schedule as step:speed:direction entries
+//   weather = 0:5:0:0; 200:15:90:0.2  # weather keyframes as step:speed:direction:dryingRate, interpolated (spread mode only)
+//   spotting = 20:0.05:0.5        # ember spotting as maxDistance:emberRate:ignitionFactor, off by default (spread mode only)
+//   drying = 20:0.002:3           # fuel drying as equilibriumMoisture:dryingRate:preheat, off by default (spread mode only)
+//   suppression = 30:firebreak:1:brush:1:10,10,10,40; 20:water:30:polygon:5,5,5,15,15,15
+//                                 # step:firebreak|retardant|water:strength:brush:radius:path or ...:polygon:vertices (spread mode only)
+//   mode = spread                 # simulation to run: spread, policy, fastMarching or fuel
+//   seed = 7                      # seed of the simulation's random draws
+//   maxSteps = 1000
+//   outputs = summary, checkpoint  # also asc (ESRI ASCII grids) and rle (run-length encoded rasters) of state, ignition time and burn duration
+//                                 # and stats (burning, burned, perimeter and spread per step as CSV)
+//
+// Any value can list alternatives separated by '|', and integer alternatives can be ranges written as "from..to".
+// A file expands into one scenario for every combination, so "seed = 1..1000" alone describes a sweep of a thousand runs.
+
+struct WindChange {
+    int step;
+    float speed;
+    int direction;
+};
+
+struct Scenario {
+    std::string name;
+
+    int worldSize = 30;
+    float lakeThreshold = 0.15f;
+    int rivers = 3;
+    unsigned int worldSeed = 0;
+
+    std::vector<std::pair<int, int>> ignitions;
+    std::vector<WindChange> wind; // Sorted by step, wind keeps the world defaults when empty
+    WeatherSchedule weather;
+    bool spotting = false;
+    SuppressionPlan suppression;
+    bool drying = false;
+    FuelDryingSettings dryingSettings;
+    SpottingSettings spottingSettings;
+    std::string mode = "spread";
+    uint32_t seed = 0;
+    int maxSteps = 10000;
+    std::vector<std::string> outputs = {"summary"};
+
+    bool HasOutput(const std::string& output) const {
+        return std::find(outputs.begin(), outputs.end(), output) != outputs.end();
+    }
+};
+
+// Parser of scenario files.
+class ScenarioFile {
+public:
+    // Reads a scenario file and expands it into all the scenarios it describes. Throws with the file and line on malformed input.
+    static std::vector<Scenario> Load(const std::string& path, const std::string& defaultName) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot open scenario file " + path);
+        }
+        return Parse(file, path, defaultName);
+    }
+
+    // Same as Load for scenario text from any stream, e.g. a request of the simulation service. source names the text in errors.
+    static std::vector<Scenario> Parse(std::istream& in, const std::string& source, const std::string& defaultName) {
+        struct Setting {
+            std::string key;
+            std::vector<std::string> alternatives;
+            int lineNumber;
+        };
+        std::vector<Setting> settings; // In file order
+        std::string line;
+        for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+            line = Trim(line.substr(0, line.find('#')));
+            if (line.empty()) {
+                continue;
+            }
+            std::size_t equals = line.find('=');
+            if (equals == std::string::npos) {
+                throw std::runtime_error(source + ":" + std::to_string(lineNumber) + ": expected key = value");
+            }
+            try {
+                settings.push_back({Trim(line.substr(0, equals)), ExpandAlternatives(line.substr(equals + 1)), lineNumber});
+            } catch (const std::exception& e) {
+                throw std::runtime_error(source + ":" + std::to_string(lineNumber) + ": " + e.what());
+            }
+        }
+
+        std::size_t combinations = 1;
+        for (const auto& setting : settings) {
+            combinations *= setting.alternatives.size();
+        }
+
+        std::vector<Scenario> scenarios;
+        scenarios.reserve(combinations);
+        for (std::size_t combination = 0; combination < combinations; ++combination) {
+            Scenario scenario;
+            scenario.name = defaultName;
+            std::size_t remainder = combination;
+            for (const auto& setting : settings) {
+                const auto& value = setting.alternatives[remainder % setting.alternatives.size()];
+                remainder /= setting.alternatives.size();
+                try {
+                    ApplySetting(scenario, setting.key, value);
+                } catch (const std::exception& e) {
+                    throw std::runtime_error(source + ":" + std::to_string(setting.lineNumber) + ": " + setting.key + ": " + e.what());
+                }
+            }
+            if (combinations > 1) {
+                scenario.name += "_" + std::to_string(combination);
+            }
+            scenarios.push_back(std::move(scenario));
+        }
+        return scenarios;
+    }
+
+private:
+    static std::string Trim(const std::string& text) {
+        std::size_t begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos) {
+            return "";
+        }
+        std::size_t end = text.find_last_not_of(" \t\r\n");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    static std::vector<std::string> Split(const std::string& text, char separator) {
+        std::vector<std::string> parts;
+        std::stringstream stream(text);
+        std::string part;
+        while (std::getline(stream, part, separator)) {
+            part = Trim(part);
+            if (!part.empty()) {
+                parts.push_back(part);
+            }
+        }
+        return parts;
+    }
+
+    // Numbers have to fill the whole token, std::stoi and friends alone would read "10x" as 10.
+    template <typename T, typename Convert>
+    static T ParseNumber(const std::string& text, Convert convert) {
+        std::size_t end = 0;
+        T number{};
+        try {
+            number = convert(text, &end);
+        } catch (const std::out_of_range&) {
+            throw std::invalid_argument("Number out of range: " + text);
+        } catch (const std::invalid_argument&) {
+            end = 0;
+        }
+        if (end == 0 || end != text.size()) {
+            throw std::invalid_argument("Not a number: " + text);
+        }
+        return number;
+    }
+
+    static int ParseInt(const std::string& text) {
+        return ParseNumber<int>(text, [](const std::string& t, std::size_t* end) { return std::stoi(t, end); });
+    }
+
+    static long ParseLong(const std::string& text) {
+        return ParseNumber<long>(text, [](const std::string& t, std::size_t* end) { return std::stol(t, end); });
+    }
+
+    static unsigned long ParseUnsigned(const std::string& text) {
+        return ParseNumber<unsigned long>(text, [](const std::string& t, std::size_t* end) { return std::stoul(t, end); });
+    }
+
+    static float ParseFloat(const std::string& text) {
+        return ParseNumber<float>(text, [](const std::string& t, std::size_t* end) { return std::stof(t, end); });
+    }
+
+    // Splits a value into its alternatives, expanding integer ranges "from..to".
+    static std::vector<std::string> ExpandAlternatives(const std::string& value) {
+        std::vector<std::string> alternatives;
+        for (const auto& alternative : Split(value, '|')) {
+            std::size_t dots = alternative.find("..");
+            if (dots != std::string::npos) {
+                long from = ParseLong(Trim(alternative.substr(0, dots)));
+                long to = ParseLong(Trim(alternative.substr(dots + 2)));
+                for (long i = from; i <= to; ++i) {
+                    alternatives.push_back(std::to_string(i));
+                }
+            } else {
+                alternatives.push_back(alternative);
+            }
+        }
+        if (alternatives.empty()) {
+            alternatives.push_back("");
+        }
+        return alternatives;
+    }
+
+    // Sets one key of the scenario from a single (already expanded) value.
+    static void ApplySetting(Scenario& scenario, const std::string& key, const std::string& value) {
+        if (key == "name") {
+            scenario.name = value;
+        } else if (key == "world.size") {
+            scenario.worldSize = ParseInt(value);
+        } else if (key == "world.lakeThreshold") {
+            scenario.lakeThreshold = ParseFloat(value);
+        } else if (key == "world.rivers") {
+            scenario.rivers = ParseInt(value);
+        } else if (key == "world.seed") {
+            scenario.worldSeed = static_cast<unsigned int>(ParseUnsigned(value));
+        } else if (key == "ignition") {
+            scenario.ignitions.clear();
+            for (const auto& pair : Split(value, ';')) {
+                auto coordinates = Split(pair, ',');
+                if (coordinates.size() != 2) {
+                    throw std::runtime_error("Ignition has to be written as x,y: " + pair);
+                }
+                scenario.ignitions.emplace_back(ParseInt(coordinates[0]), ParseInt(coordinates[1]));
+            }
+        } else if (key == "wind") {
+            scenario.wind.clear();
+            for (const auto& entry : Split(value, ';')) {
+                auto fields = Split(entry, ':');
+                if (fields.size() != 3) {
+                    throw std::runtime_error("Wind has to be written as step:speed:direction: " + entry);
+                }
+                scenario.wind.push_back({ParseInt(fields[0]), ParseFloat(fields[1]), ParseInt(fields[2])});
+            }
+            std::sort(scenario.wind.begin(), scenario.wind.end(), [](const WindChange& a, const WindChange& b) { return a.step < b.step; });
+        } else if (key == "weather") {
+            scenario.weather = WeatherSchedule();
+            for (const auto& entry : Split(value, ';')) {
+                auto fields = Split(entry, ':');
+                if (fields.size() != 4) {
+                    throw std::runtime_error("Weather has to be written as step:speed:direction:dryingRate: " + entry);
+                }
+                scenario.weather.AddKeyframe({ParseInt(fields[0]), ParseFloat(fields[1]), ParseInt(fields[2]), ParseFloat(fields[3])});
+            }
+        } else if (key == "spotting") {
+            auto fields = Split(value, ':');
+            scenario.spotting = value != "off";
+            if (scenario.spotting) {
+                if (fields.size() != 3) {
+                    throw std::runtime_error("Spotting has to be written as maxDistance:emberRate:ignitionFactor or off: " + value);
+                }
+                scenario.spottingSettings = {ParseInt(fields[0]), ParseFloat(fields[1]), ParseFloat(fields[2])};
+            }
+        } else if (key == "drying") {
+            auto fields = Split(value, ':');
+            scenario.drying = value != "off";
+            if (scenario.drying) {
+                if (fields.size() != 3) {
+                    throw std::runtime_error("Drying has to be written as equilibriumMoisture:dryingRate:preheat or off: " + value);
+                }
+                scenario.dryingSettings = {ParseFloat(fields[0]), ParseFloat(fields[1]), ParseFloat(fields[2])};
+            }
+        } else if (key == "suppression") {
+            scenario.suppression = SuppressionPlan();
+            for (const auto& entry : Split(value, ';')) {
+                scenario.suppression.AddAction(ParseSuppressionAction(entry));
+            }
+        } else if (key == "mode") {
+            scenario.mode = value;
+        } else if (key == "seed") {
+            scenario.seed = static_cast<uint32_t>(ParseUnsigned(value));
+        } else if (key == "maxSteps") {
+            scenario.maxSteps = ParseInt(value);
+        } else if (key == "outputs") {
+            scenario.outputs = Split(value, ',');
+        } else {
+            throw std::runtime_error("Unknown scenario setting: " + key);
+        }
+    }
+
+    static SuppressionAction ParseSuppressionAction(const std::string& entry) {
+        auto fields = Split(entry, ':');
+        bool isBrush = fields.size() == 6 && fields[3] == "brush";
+        if (!isBrush && !(fields.size() == 5 && fields[3] == "polygon")) {
+            throw std::runtime_error("Suppression has to be written as step:type:strength:brush:radius:x,y,... or step:type:strength:polygon:x,y,...: " + entry);
+        }
+
+        SuppressionType type;
+        if (fields[1] == "firebreak") {
+            type = SuppressionType::Firebreak;
+        } else if (fields[1] == "retardant") {
+            type = SuppressionType::Retardant;
+        } else if (fields[1] == "water") {
+            type = SuppressionType::Water;
+        } else {
+            throw std::runtime_error("Unknown suppression type: " + fields[1]);
+        }
+
+        auto coordinates = Split(fields.back(), ',');
+        if (coordinates.size() % 2 != 0) {
+            throw std::runtime_error("Suppression coordinates have to be x,y pairs: " + fields.back());
+        }
+        std::vector<std::pair<float, float>> points;
+        for (std::size_t i = 0; i < coordinates.size(); i += 2) {
+            points.emplace_back(ParseFloat(coordinates[i]), ParseFloat(coordinates[i + 1]));
+        }
+
+        int step = ParseInt(fields[0]);
+        float strength = ParseFloat(fields[2]);
+        return isBrush ? SuppressionAction::Brush(step, type, strength, std::move(points), ParseFloat(fields[4]))
+                       : SuppressionAction::Polygon(step, type, strength, std::move(points));
+    }
+};
@@ -0,0 +1,349 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+
+#include "worldClasses.h"
+#include "worldGenerator.h"
+#include "simulation.h"
+#include "fastMarchingSimulation.h"
+#include "fireStatistics.h"
+#include "fuelSimulation.h"
+#include "policySimulation.h"
+#include "rasterExport.h"
+#include "scenario.h"
+#include "taskScheduler.h"
+
+// Outcome of one scenario run, one line of the results table.
+struct ScenarioResult {
+    std::string name;
+    bool succeeded = false;
+    std::string error;
+
+    int steps = 0;
+    std::size_t burnedTiles = 0;
+    std::size_t burningTiles = 0;
+
+    bool worldFromCache = false;
+    double worldSeconds = 0; // Generating or copying the world
+    double simulationSeconds = 0;
+    double outputSeconds = 0;
+};
+
+// Keeps generated worlds in memory, so scenarios with the same world settings generate it only once.
+// Every run gets its own copy of the terrain, because simulations store their state in the world's parameters.
+class WorldCache {
+    using Key = std::tuple<int, float, int, unsigned int>; // Size, lake threshold, rivers, seed
+
+    std::mutex mutex_;
+    std::mutex generationMutex_;
+    std::map<Key, std::shared_ptr<World>> worlds_;
+    std::vector<Key> insertionOrder_;
+    std::size_t capacity_;
+    TaskScheduler* scheduler_;
+
+public:
+    // Worlds are generated on the scheduler if one is given.
+    explicit WorldCache(std::size_t capacity = 64, TaskScheduler* scheduler = nullptr)
+            : capacity_(std::max<std::size_t>(1, capacity)), scheduler_(scheduler) {}
+
+    // Returns a private copy of the world described by the scenario, generating it first if it is not cached.
+    std::shared_ptr<World> Acquire(const Scenario& scenario, bool& fromCache) {
+        Key key(scenario.worldSize, scenario.lakeThreshold, scenario.rivers, scenario.worldSeed);
+        std::shared_ptr<World> world = Find(key);
+        fromCache = world != nullptr;
+        if (!fromCache) {
+            // Generation uses the global rand() state, so it is serialized by its own lock; lookups of cached worlds do not wait for it
+            std::lock_guard<std::mutex> generationLock(generationMutex_);
+            world = Find(key);
+            fromCache = world != nullptr;
+            if (!fromCache) {
+                WorldGenerator generator(scenario.worldSize, scenario.worldSize, scenario.lakeThreshold, scenario.rivers, scenario.worldSeed);
+                generator.scheduler = scheduler_;
+                world = generator.Generate();
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                worlds_[key] = world;
+                insertionOrder_.push_back(key);
+                if (insertionOrder_.size() > capacity_) {
+                    worlds_.erase(insertionOrder_.front()); // Runs still using it keep their own reference
+                    insertionOrder_.erase(insertionOrder_.begin());
+                }
+            }
+        }
+        return world->CopyTerrain();
+    }
+
+private:
+    std::shared_ptr<World> Find(const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = worlds_.find(key);
+        return it != worlds_.end() ? it->second : nullptr;
+    }
+};
+
+// One scenario set up for running: a private copy of its world and the configured simulation, started from its ignitions. Steps apply the
+// wind schedule, so callers can run to the end in one go or look at the state between steps.
+class ScenarioRun {
+    const Scenario& scenario_;
+    std::shared_ptr<World> world_;
+    std::unique_ptr<FireStatistics> statistics_;
+    std::unique_ptr<Simulation> simulation_;
+    std::vector<Tile*> startingTiles_;
+    std::vector<WindChange>::const_iterator windChange_;
+    int steps_ = 0;
+    bool worldFromCache_ = false;
+
+public:
+    // The scenario must outlive the run. The scheduler, if given, is used for the updates of large spread fires.
+    ScenarioRun(const Scenario& scenario, WorldCache& worldCache, TaskScheduler* scheduler) : scenario_(scenario) {
+        world_ = worldCache.Acquire(scenario, worldFromCache_);
+        statistics_ = std::make_unique<FireStatistics>(*world_);
+        simulation_ = CreateSimulation(scenario.mode, *world_, scenario.seed);
+        simulation_->Subscribe(*statistics_, StepCompletedEvents);
+        auto* fireSpread = dynamic_cast<FireSpreadSimulation*>(simulation_.get());
+        if (fireSpread != nullptr) {
+            fireSpread->SetScheduler(scheduler);
+        }
+        if (!scenario.weather.IsEmpty() || scenario.spotting || !scenario.suppression.IsEmpty() || scenario.drying) {
+            if (fireSpread == nullptr) {
+                throw std::runtime_error("Weather, spotting, suppression and drying are only available in spread mode");
+            }
+            if (!scenario.weather.IsEmpty()) {
+                fireSpread->SetWeather(scenario.weather);
+            }
+            if (scenario.spotting) {
+                fireSpread->SetSpotting(scenario.spottingSettings);
+            }
+            fireSpread->SetSuppressionPlan(scenario.suppression);
+            if (scenario.drying) {
+                fireSpread->SetDrying(scenario.dryingSettings);
+            }
+        }
+        auto prohibited = simulation_->GetProhibitedTiles();
+        std::unordered_set<Tile*> prohibitedTiles(prohibited.begin(), prohibited.end());
+        for (const auto& [x, y] : scenario.ignitions) {
+            Tile* tile = world_->GetTileAt(x, y);
+            if (prohibitedTiles.count(tile) == 0) {
+                startingTiles_.push_back(tile);
+            }
+        }
+        simulation_->Initialize(startingTiles_);
+        windChange_ = scenario.wind.begin();
+    }
+
+    // Whether the fire is out or the step limit is reached.
+    bool HasEnded() const {
+        return simulation_->HasEnded() || steps_ >= scenario_.maxSteps;
+    }
+
+    // Applies the wind entries of the next step, then updates the simulation. Wind entries take effect from their step on, i.e. before the
+    // update producing that step.
+    void Step() {
+        for (; windChange_ != scenario_.wind.end() && windChange_->step <= steps_ + 1; ++windChange_) {
+            SetWind(*world_, windChange_->speed, windChange_->direction);
+        }
+        simulation_->Update();
+        steps_++;
+    }
+
+    int GetSteps() const {
+        return steps_;
+    }
+
+    bool IsWorldFromCache() const {
+        return worldFromCache_;
+    }
+
+    World& GetWorld() {
+        return *world_;
+    }
+
+    Simulation& GetSimulation() {
+        return *simulation_;
+    }
+
+    // Statistics of the fire, updated with every step from the step's changes.
+    const FireStatistics& GetStatistics() const {
+        return *statistics_;
+    }
+
+    // Tiles set burning by the initialization, i.e. the ignitions that are not prohibited.
+    const std::vector<Tile*>& GetStartingTiles() const {
+        return startingTiles_;
+    }
+
+    // Creates the simulation selected by a scenario's mode.
+    static std::unique_ptr<Simulation> CreateSimulation(const std::string& mode, World& world, uint32_t seed) {
+        if (mode == "spread") {
+            return std::make_unique<FireSpreadSimulation>(world, seed);
+        }
+        if (mode == "fastMarching") {
+            return std::make_unique<FastMarchingSimulation>(world); // Deterministic, the seed is not used
+        }
+        if (mode == "policy") {
+            return std::make_unique<FastSpreadSimulation>(world, seed);
+        }
+        if (mode == "fuel") {
+            return std::make_unique<FuelSimulation>(world); // Deterministic, the seed is not used
+        }
+        throw std::runtime_error("Unknown simulation mode: " + mode);
+    }
+
+private:
+    static void SetWind(World& world, float speed, int direction) {
+        auto windSpeed = world.GetParameter<float>("windSpeed");
+        auto windDirection = world.GetParameter<int>("windDirection");
+        if (!windSpeed || !windDirection) {
+            throw std::runtime_error("Simulation has no wind parameters");
+        }
+        windSpeed->SetValue(speed);
+        windDirection->SetValue(direction);
+    }
+};
+
+// Runs batches of scenarios concurrently and writes per-scenario outputs plus a results table. Scenarios, the generation of their worlds,
+// the updates of large spread fires and the output files all share one task scheduler, so small batches of large worlds still use every worker.
+class ScenarioRunner {
+    TaskScheduler scheduler_;
+    WorldCache worldCache_;
+
+public:
+    explicit ScenarioRunner(std::size_t threadCount = std::thread::hardware_concurrency())
+            : scheduler_(threadCount), worldCache_(64, &scheduler_) {}
+
+    // Loads every *.scenario file of a directory (sweeps expanded) and runs all of them.
+    std::vector<ScenarioResult> RunDirectory(const std::string& scenarioDirectory, const std::string& outputDirectory) {
+        std::vector<std::filesystem::path> files;
+        for (const auto& entry : std::filesystem::directory_iterator(scenarioDirectory)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".scenario") {
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+
+        std::vector<Scenario> scenarios;
+        for (const auto& file : files) {
+            auto loaded = ScenarioFile::Load(file.string(), file.stem().string());
+            scenarios.insert(scenarios.end(), std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+        }
+        return Run(scenarios, outputDirectory);
+    }
+
+    // Runs the scenarios concurrently and writes "results.csv" with one line per scenario to the output directory.
+    std::vector<ScenarioResult> Run(const std::vector<Scenario>& scenarios, const std::string& outputDirectory) {
+        std::filesystem::create_directories(outputDirectory);
+
+        std::vector<ScenarioResult> results(scenarios.size());
+        TaskGroup runs;
+        for (std::size_t i = 0; i < scenarios.size(); ++i) {
+            scheduler_.Submit(runs, [this, &scenarios, &results, &outputDirectory, i] {
+                results[i] = RunScenario(scenarios[i], outputDirectory);
+            });
+        }
+        scheduler_.Wait(runs);
+
+        WriteResultsTable(results, outputDirectory + "/results.csv");
+        return results;
+    }
+
+    // Runs one scenario to its end or to its step limit. Failures are reported in the result instead of being thrown.
+    ScenarioResult RunScenario(const Scenario& scenario, const std::string& outputDirectory) {
+        using Clock = std::chrono::steady_clock;
+        ScenarioResult result;
+        result.name = scenario.name;
+
+        try {
+            auto start = Clock::now();
+            ScenarioRun run(scenario, worldCache_, &scheduler_);
+            result.worldFromCache = run.IsWorldFromCache();
+            auto worldReady = Clock::now();
+
+            while (!run.HasEnded()) {
+                run.Step();
+            }
+            result.steps = run.GetSteps();
+            auto simulationDone = Clock::now();
+
+            result.burningTiles = run.GetStatistics().GetCurrent().burningTiles;
+            result.burnedTiles = run.GetStatistics().GetCurrent().burnedTiles;
+
+            WriteOutputs(scenario, run.GetSimulation(), run.GetWorld(), run.GetStatistics(), result, outputDirectory);
+            auto outputsDone = Clock::now();
+
+            result.worldSeconds = std::chrono::duration<double>(worldReady - start).count();
+            result.simulationSeconds = std::chrono::duration<double>(simulationDone - worldReady).count();
+            result.outputSeconds = std::chrono::duration<double>(outputsDone - simulationDone).count();
+            result.succeeded = true;
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+        return result;
+    }
+
+private:
+    void WriteOutputs(const Scenario& scenario, Simulation& simulation, World& world, const FireStatistics& statistics, const ScenarioResult& result,
+                      const std::string& outputDirectory) {
+        std::string basePath = outputDirectory + "/" + scenario.name;
+
+        if (scenario.HasOutput("summary")) {
+            std::ofstream summary(basePath + ".summary");
+            summary << "name = " << scenario.name << "\n"
+                    << "mode = " << scenario.mode << "\n"
+                    << "seed = " << scenario.seed << "\n"
+                    << "world.seed = " << scenario.worldSeed << "\n"
+                    << "steps = " << result.steps << "\n"
+                    << "ended = " << (simulation.HasEnded() ? "yes" : "no") << "\n"
+                    << "burnedTiles = " << result.burnedTiles << "\n"
+                    << "burningTiles = " << result.burningTiles << "\n"
+                    << "perimeter = " << statistics.GetCurrent().perimeter << "\n";
+        }
+
+        if (scenario.HasOutput("stats")) {
+            std::ofstream stats(basePath + ".stats.csv");
+            statistics.WriteCsv(stats);
+        }
+
+        if (scenario.HasOutput("asc") || scenario.HasOutput("rle")) {
+            // The layers are written in the background while the workers have nothing more urgent to do
+            RasterExporter exporter(world);
+            const std::pair<RasterLayer, std::string> layers[] = {
+                    {RasterLayer::FinalState, "state"}, {RasterLayer::IgnitionTime, "ignition"}, {RasterLayer::BurnDuration, "duration"}};
+            TaskGroup exports;
+            for (const auto& [layer, layerName] : layers) {
+                std::string layerPath = basePath + "." + layerName;
+                if (scenario.HasOutput("asc")) {
+                    scheduler_.Submit(exports, [&exporter, layer = layer, layerPath] { exporter.WriteAsciiGrid(layer, layerPath + ".asc"); }, TaskPriority::Low);
+                }
+                if (scenario.HasOutput("rle")) {
+                    scheduler_.Submit(exports, [&exporter, layer = layer, layerPath] { exporter.WriteRunLength(layer, layerPath + ".rle"); }, TaskPriority::Low);
+                }
+            }
+            scheduler_.Wait(exports);
+        }
+
+        if (scenario.HasOutput("checkpoint")) {
+            auto* fireSpread = dynamic_cast<FireSpreadSimulation*>(&simulation);
+            if (fireSpread == nullptr) {
+                throw std::runtime_error("Checkpoint output is only available in spread mode");
+            }
+            auto blob = fireSpread->Checkpoint();
+            std::ofstream file(basePath + ".checkpoint", std::ios::binary);
+            file.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+        }
+    }
+
+    static void WriteResultsTable(const std::vector<ScenarioResult>& results, const std::string& path) {
+        std::ofstream table(path);
+        table << "name,status,steps,burnedTiles,burningTiles,worldCached,worldSeconds,simulationSeconds,outputSeconds,error\n";
+        for (const auto& result : results) {
+            table << result.name << "," << (result.succeeded ? "ok" : "failed") << "," << result.steps << ","
+                  << result.burnedTiles << "," << result.burningTiles << "," << (result.worldFromCache ? "yes" : "no") << ","
+                  << result.worldSeconds << "," << result.simulationSeconds << "," << result.outputSeconds << ","
+                  << "\"" << result.error << "\"\n";
+        }
+    }
+};
@@ -0,0 +1,147 @@
+#include <SFML/Graphics.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "fuelSimulation.h"
+#include "worldGenerator.h"
+
+// Invariants of the simulations that no single run would notice, checked on generated worlds: fuel accounting and heap allocations of
+// the update loop. Prints one line per check and exits with 2 if any of them fails.
+// Usage: fireSelfCheck [--size=200] [--seed=7]
+
+// Heap allocations made while counting is on, by any thread. The replacements are not inlined, so the compiler does not pair the new
+// expressions of the library with malloc and free.
+static std::atomic<bool> countAllocations{false};
+static std::atomic<std::size_t> allocationCount{0};
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    if (countAllocations.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+__attribute__((noinline)) void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+// Sequential FireSpreadSimulation updates must not allocate once their buffers are warm. The fire is run to its end once, which grows the
+// buffers to the size of the fire, then restored to its start from a checkpoint and run again, and that second run must not allocate.
+static bool CheckSpreadAllocations(int size, int seed) {
+    WorldGenerator generator(size, size, 0.15f, 3, static_cast<unsigned int>(seed));
+    auto world = generator.Generate();
+    FireSpreadSimulation simulation(*world, static_cast<uint32_t>(seed));
+    world->GetParameter<float>("windSpeed")->SetValue(12.0f);
+    std::vector<Tile*> startingTiles;
+    for (int x = 10; x < size; x += 20) {
+        for (int y = 10; y < size; y += 20) {
+            if (world->GetTileAt(x, y)->GetMoisture() != 100) {
+                startingTiles.push_back(world->GetTileAt(x, y)); // A lattice of ignitions, so the fire covers the world
+            }
+        }
+    }
+    simulation.Initialize(startingTiles);
+    std::vector<uint8_t> start = simulation.Checkpoint();
+
+    std::size_t allocations[2] = {0, 0};
+    int steps = 0;
+    for (int run = 0; run < 2; ++run) {
+        if (run > 0) {
+            simulation.Restore(start);
+        }
+        steps = 0;
+        while (!simulation.HasEnded()) {
+            allocationCount = 0;
+            countAllocations = true;
+            simulation.Update();
+            countAllocations = false;
+            allocations[run] += allocationCount;
+            steps++;
+        }
+    }
+    std::cout << "spread update allocations: " << allocations[0] << " while the buffers grow, " << allocations[1] << " in " << steps
+              << " warm steps" << std::endl;
+    return allocations[1] == 0;
+}
+
+// Every tile whose fuel was consumed must end up burned, also when it ignites and burns out within one step (fast spread or short burn time),
+// and a higher spread rate must not burn a smaller area, which it would if tiles burned out before heating their neighbors.
+static bool CheckFuelBurnouts(int size, int seed) {
+    bool passed = true;
+    std::size_t previousConsumed = 0;
+    for (float spreadRate : {1.0f, 4.0f, 10.0f}) {
+        WorldGenerator generator(size, size, 0.15f, 3, static_cast<unsigned int>(seed));
+        auto world = generator.Generate();
+        FuelSimulation simulation(*world, spreadRate);
+        std::vector<Tile*> startingTiles;
+        for (int x = size / 2; x < size && startingTiles.empty(); ++x) {
+            if (world->GetTileAt(x, size / 2)->GetMoisture() != 100) {
+                startingTiles.push_back(world->GetTileAt(x, size / 2)); // First land tile right of the center
+            }
+        }
+        simulation.Initialize(startingTiles);
+        while (!simulation.HasEnded()) {
+            simulation.Update();
+        }
+
+        auto hasBurnedParam = world->GetVectorParameter<bool>("hasBurned");
+        auto ignitionTimeParam = world->GetVectorParameter<int>("ignitionTime");
+        std::size_t consumed = 0;
+        std::size_t unmarked = 0;
+        for (int x = 0; x < size; ++x) {
+            for (int y = 0; y < size; ++y) {
+                Tile* tile = world->GetTileAt(x, y);
+                if (tile->GetMoisture() == 100 || simulation.GetFuel(tile) >= simulation.GetFuelLoad(tile->GetVegetation())) {
+                    continue;
+                }
+                std::size_t tileIndex = world->GetTileIndex(tile);
+                consumed++;
+                unmarked += !hasBurnedParam->GetValue(tileIndex) || ignitionTimeParam->GetValue(tileIndex) < 0;
+            }
+        }
+        std::cout << "fuel burnouts, spread rate " << spreadRate << ": " << consumed << " tiles with consumed fuel, " << unmarked
+                  << " not marked burned" << std::endl;
+        passed = passed && unmarked == 0 && consumed >= previousConsumed;
+        previousConsumed = consumed;
+    }
+    return passed;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        int size = 200;
+        int seed = 7;
+        for (int i = 1; i < argc; ++i) {
+            std::string option = argv[i];
+            std::size_t equals = option.find('=');
+            std::string key = option.substr(0, equals);
+            std::string value = equals == std::string::npos ? "" : option.substr(equals + 1);
+            if (key == "--size") {
+                size = std::max(3, std::stoi(value));
+            } else if (key == "--seed") {
+                seed = std::stoi(value);
+            } else {
+                throw std::runtime_error("Unknown option: " + option);
+            }
+        }
+
+        bool passed = CheckFuelBurnouts(size, seed);
+        passed = CheckSpreadAllocations(size, seed) && passed;
+        std::cout << (passed ? "All checks passed" : "Some checks failed") << std::endl;
+        return passed ? 0 : 2;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
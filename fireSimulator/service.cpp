@@ -0,0 +1,56 @@
+#include <SFML/Graphics.hpp>
+
+#include <csignal>
+#include <iostream>
+
+#include "simulationService.h"
+
+static SimulationService* runningService = nullptr;
+
+static void StopService(int) {
+    if (runningService != nullptr) {
+        runningService->Stop();
+    }
+}
+
+// Simulation service daemon, see simulationService.h for the protocol. Runs until interrupted.
+// Usage: fireService <socket path> [--threads=N] [--queue=64] [--worlds=16] [--timeout=10]
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <socket path> [--threads=N] [--queue=64] [--worlds=16] [--timeout=10]" << std::endl;
+        return 1;
+    }
+
+    try {
+        ServiceSettings settings;
+        for (int i = 2; i < argc; ++i) {
+            std::string option = argv[i];
+            std::size_t equals = option.find('=');
+            std::string key = option.substr(0, equals);
+            std::string value = equals == std::string::npos ? "" : option.substr(equals + 1);
+            if (key == "--threads") {
+                settings.threads = std::stoul(value);
+            } else if (key == "--queue") {
+                settings.maxQueuedRuns = std::stoul(value);
+            } else if (key == "--worlds") {
+                settings.cachedWorlds = std::stoul(value);
+            } else if (key == "--timeout") {
+                settings.timeoutSeconds = std::stoi(value);
+            } else {
+                throw std::runtime_error("Unknown option: " + option);
+            }
+        }
+
+        SimulationService service(argv[1], settings);
+        runningService = &service;
+        std::signal(SIGINT, StopService);
+        std::signal(SIGTERM, StopService);
+        std::cout << "Listening at " << service.GetSocketPath() << std::endl;
+        service.Serve();
+        runningService = nullptr;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
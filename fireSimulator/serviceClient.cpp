@@ -0,0 +1,82 @@
+#include <SFML/Graphics.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "simulationService.h"
+
+// Sends a scenario to a running fireService and reports the streamed steps, e.g. to check the latency to the first frame.
+// Usage: fireServiceClient <socket path> <scenario file> [--quiet]
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <socket path> <scenario file> [--quiet]" << std::endl;
+        return 1;
+    }
+    bool quiet = argc > 3 && std::string(argv[3]) == "--quiet";
+
+    try {
+        std::ifstream file(argv[2]);
+        if (!file) {
+            throw std::runtime_error(std::string("Cannot open scenario file ") + argv[2]);
+        }
+        std::string scenario((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        using Clock = std::chrono::steady_clock;
+        auto start = Clock::now();
+        auto milliseconds = [&start] { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+        auto connection = ServiceConnection::Connect(argv[1]);
+        try {
+            connection.Send(ServiceFrame::Request, scenario);
+        } catch (const std::system_error&) {
+            // A busy service rejects before reading the request, its Error frame is still waiting to be read
+        }
+
+        ServiceFrame type;
+        std::vector<uint8_t> payload;
+        std::size_t changes = 0;
+        bool first = true;
+        while (connection.Receive(type, payload)) {
+            if (first) {
+                std::cout << "First frame after " << milliseconds() << " ms" << std::endl;
+                first = false;
+            }
+            BinaryReader reader(payload);
+            switch (type) {
+                case ServiceFrame::Started: {
+                    uint64_t width = reader.ReadVarUInt();
+                    uint64_t depth = reader.ReadVarUInt();
+                    bool cached = reader.Read<uint8_t>() != 0;
+                    std::cout << "Started on a " << width << "x" << depth << (cached ? " cached" : " generated") << " world" << std::endl;
+                    break;
+                }
+                case ServiceFrame::Step: {
+                    ServiceStep step = ServiceStep::Decode(payload);
+                    changes += step.changes.size();
+                    if (!quiet) {
+                        std::cout << "Step " << step.step << ": " << step.changes.size() << " changes (" << payload.size() << " bytes)" << std::endl;
+                    }
+                    break;
+                }
+                case ServiceFrame::Finished: {
+                    uint64_t steps = reader.ReadVarUInt();
+                    uint64_t burned = reader.ReadVarUInt();
+                    uint64_t burning = reader.ReadVarUInt();
+                    bool ended = reader.Read<uint8_t>() != 0;
+                    std::cout << "Finished after " << steps << " steps (" << (ended ? "fire out" : "step limit") << "): " << burned << " burned, "
+                              << burning << " burning, " << changes << " changes streamed in " << milliseconds() << " ms" << std::endl;
+                    return 0;
+                }
+                case ServiceFrame::Error:
+                    std::cerr << "Service error: " << std::string(payload.begin(), payload.end()) << std::endl;
+                    return 2;
+                default:
+                    throw std::runtime_error("Unexpected frame type " + std::to_string(static_cast<int>(type)));
+            }
+        }
+        throw std::runtime_error("Connection closed before the run finished");
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
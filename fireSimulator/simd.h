@@ -0,0 +1,31 @@
+#pragma once
+
+// Vectorized kernels are compiled for AVX2 on x86-64 with GCC or Clang and selected at runtime, so the binary still runs on older CPUs.
+// On other targets (e.g. Apple Silicon) only the scalar kernels are built, which the compiler auto-vectorizes for the native SIMD unit.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define FIRESIM_X86_SIMD 1
+#include <immintrin.h>
+#define FIRESIM_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define FIRESIM_X86_SIMD 0
+#endif
+
+// Forces a kernel body shared by a generic and a target-specific function to be inlined into both, so each copy is compiled for its target.
+#if defined(__GNUC__) || defined(__clang__)
+#define FIRESIM_INLINE inline __attribute__((always_inline))
+#else
+#define FIRESIM_INLINE inline
+#endif
+
+// Runtime detection of the instruction sets used by the vectorized kernels.
+class CpuFeatures {
+public:
+    static bool HasAvx2() {
+#if FIRESIM_X86_SIMD
+        static const bool hasAvx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        return hasAvx2;
+#else
+        return false;
+#endif
+    }
+};
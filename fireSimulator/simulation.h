@@ -1,6 +1,14 @@
 #pragma once
+#include <SFML/Graphics/Color.hpp>
 #include "worldClasses.h"
-
+#include "perlin.h"
+#include "binaryIO.h"
+#include "weather.h"
+#include "spotting.h"
+#include "suppression.h"
+#include "taskScheduler.h"
+#include "simd.h"
+#include "simulationObserver.h"
 
 class Simulation {
 public:
@@ -9,11 +17,23 @@ public:
     virtual void Update() = 0;
     virtual bool HasEnded() const = 0;
     virtual void Reset() = 0;
-    virtual std::vector<Tile*> GetLastChangedTiles() const = 0;
+    virtual const std::vector<Tile*>& GetLastChangedTiles() const = 0;
     virtual std::vector<Tile*> GetProhibitedTiles() const = 0;
     virtual std::unordered_map<int, sf::Color> GetChangedTileColors() const = 0;
 
+    // Registers the observer for the given events (SimulationEvent mask), delivered at the end of Initialize and of every Update. The
+    // observer has to stay alive until it is unsubscribed or the simulation is destroyed.
+    void Subscribe(SimulationObserver& observer, uint32_t events = AllSimulationEvents) {
+        events_.Subscribe(observer, events);
+    }
+
+    void Unsubscribe(SimulationObserver& observer) {
+        events_.Unsubscribe(observer);
+    }
+
 protected:
+    SimulationEvents events_; // Observers and the changes of the current step, filled where the simulations record their changes
+
 
     //  Uses a binary search algorithm to find the probability in each discrete step given the total probability and certain number of steps with the same chance/probability which together should make the total probability.
     float GetStepProbability(float totalProbability, int updateSteps) {
@@ -39,14 +59,81 @@ class FireSpreadSimulation : public Simulation {
     int currentTime_;
 
     World& world_;
+    CounterRandom random_; // Source of all random draws, advanced once per update
     std::vector<Tile*> burningTiles_; // Currently burning tiles
     std::vector<Tile*> prohibitedTiles_; // Tiles that are not allowed to be clicked or to be start the simulation on / Here: all water tiles
-    std::unordered_map<int, std::vector<Tile*>> changesOverTime_; // Tracks changed tiles at each time step - update of simulation
+    std::vector<Tile*> lastChangedTiles_; // Tiles changed in the current time step, the buffer is reused from step to step
+    std::vector<Tile*> pendingChangedTiles_; // Tiles changed by suppression between steps, reported with the next step
+    std::vector<Tile*> nextBurningTiles_; // Scratch list the next step's burning tiles are collected in, swapped with burningTiles_
+    // Per tile, set once a burning tile has no neighbor left that is neither burning nor burned. Tile states only move forward, so such a
+    // tile never attempts a spread again and is only counted down to its burnout; the rest of burningTiles_ is the fire's frontier.
+    std::vector<uint8_t> enclosed_;
+
+    WeatherSchedule weather_;
+    std::unique_ptr<EmberSpotting> spotting_; // Long-range spread by embers, off unless enabled
+    SuppressionPlan suppressionPlan_;
+    std::size_t nextAction_ = 0; // First action of the plan not applied yet
+    std::shared_ptr<TypedVectorParameter<float>> fuelFactorParam_; // Kept at hand, they are read for every spread attempt
+    std::shared_ptr<TypedVectorParameter<int>> moistureDeltaParam_;
+
+    // Lazy fuel drying, empty unless enabled. Each tile's moisture is stored as of its last update step plus the spread attempts it
+    // survived in that step, and brought forward in closed form the next time fire reaches it.
+    std::unique_ptr<FuelDryingSettings> drying_;
+    std::vector<float> fuelMoisture_;
+    std::vector<int32_t> moistureUpdatedAt_;
+    std::vector<uint16_t> preheatCount_;
+    float moistureOffset_ = 0.0f; // Moisture lost by all land tiles through the weather so far
+
+    // Spread probabilities per source tile and direction, as thresholds on the raw random bits (CounterRandom::Threshold), so an attempt is
+    // one integer compare. An entry is valid while the wind factor of its direction is unchanged since it was computed (epoch stamps) and
+    // the target is in the same moisture band, so weather changes only recompute what they affect.
+    std::vector<uint32_t> spreadThresholds_;
+    std::vector<uint32_t> spreadComputedAt_; // Epoch the entry was computed in, 0 if never
+    std::vector<uint8_t> spreadMoistureBand_;
+    float windFactors_[8] = {};
+    uint32_t windChangedAt_[8] = {};
+    uint32_t spreadEpoch_ = 0;
+    float cachedWindSpeed_ = -1.0f;
+    int cachedWindDirection_ = -1;
+
+    // Moisture band of every tile without drying and weather offset, i.e. of its moisture plus the suppression delta. While neither is
+    // active, the attempts of interior tiles check the cached thresholds of all eight neighbors at once against it (AttemptNeighbors).
+    std::vector<uint8_t> moistureBands_;
+    int32_t neighborOffsets_[8] = {}; // Tile index offsets of the eight neighbors, in GetDirectionIndex order
+    static constexpr int NeighborDeltas[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+
+    // Attempts of a burning tile on its eight neighbors, one bit per direction.
+    struct NeighborMasks {
+        uint32_t unburned; // Neighbors neither burning nor burned, i.e. attempted
+        uint32_t cached;   // Attempts with a valid cached threshold
+        uint32_t ignites;  // Attempts with a valid cached threshold that ignite the neighbor
+    };
+
+    // Spread attempt drawn ahead of the sequential update, together with the cache entry it computed if any.
+    struct SpreadAttempt {
+        Tile* target;
+        uint32_t slot;
+        uint32_t threshold;
+        uint8_t moistureBand;
+        bool computed;
+        bool ignites;
+    };
+
+    // Optional scheduler the spread attempts of large fires are drawn on. Per burning tile its 8 slots in spreadAttempts_ hold the attempts
+    // on its neighbors (target nullptr for the unused rest), applied afterwards in the order of the sequential update.
+    static constexpr std::size_t ParallelBurningTiles = 4096;
+    TaskScheduler* scheduler_ = nullptr;
+    std::vector<SpreadAttempt> spreadAttempts_;
 
 public:
-    explicit FireSpreadSimulation(World& world) : world_(world), currentTime_(0) {
+    explicit FireSpreadSimulation(World& world) : FireSpreadSimulation(world, static_cast<uint32_t>(rand())) {}
+
+    // Simulation with a fixed seed of its random draws, runs with the same seed and starting tiles are identical.
+    FireSpreadSimulation(World& world, uint32_t seed) : world_(world), currentTime_(0), random_(seed) {
         InitWorldParameters();
         SetProhibitedTiles();
+        InvalidateSpreadCache();
+        ResetEnclosedTiles();
     }
 
     //  Initializes global and tile-specific parameters relevant to fire spread, such as wind speed, direction, and fire-related properties of tiles.
@@ -62,6 +149,11 @@ public:
         world_.AddVectorParameter<bool>("hasBurned", totalTiles, false, false, true);
         world_.AddVectorParameter<int>("burningFor", totalTiles, 0, 0, 5);
         world_.AddVectorParameter<int>("burnTime", totalTiles, 5, 0, 5);
+        world_.AddVectorParameter<int>("ignitionTime", totalTiles, -1, -1, std::numeric_limits<int>::max()); // Step in which the tile caught fire, -1 if it never did
+        world_.AddVectorParameter<float>("fuelFactor", totalTiles, 1.0f, 0.0f, 1.0f); // Fuel left by suppression actions
+        world_.AddVectorParameter<int>("moistureDelta", totalTiles, 0, -100, 100); // Moisture added by suppression actions
+        fuelFactorParam_ = world_.GetVectorParameter<float>("fuelFactor");
+        moistureDeltaParam_ = world_.GetVectorParameter<int>("moistureDelta");
 
         // Initialize fire-related parameters for all tiles in the world
         for (int i = 0; i < world_.grid.size(); ++i) {
@@ -69,91 +161,303 @@ public:
                 Tile* tile = world_.grid[i][j];
                 if (tile != nullptr) {
                     int index = i * world_.GetDepth() + j;
-                    int burnTime = 5;
-
-                    switch (tile->GetVegetation()) {
-                        case VegetationType::Grass: burnTime = 1; break;
-                        case VegetationType::Sparse: burnTime = 2; break;
-                        case VegetationType::Swamp: burnTime = 3; break;
-                        case VegetationType::Forest: burnTime = 4; break;
-                    }
-
                     auto burnTimeParam = world_.GetVectorParameter<int>("burnTime");
-                    burnTimeParam->SetValue(index, burnTime);
+                    burnTimeParam->SetValue(index, GetBurnTime(tile->GetVegetation()));
                 }
             }
         }
     }
 
-    //  Identifies and records tiles that cannot be involved in the fire spread (e.g., water tiles).
+    // Number of steps a tile of the given vegetation burns.
+    static int GetBurnTime(VegetationType vegetation) {
+        switch (vegetation) {
+            case VegetationType::Grass: return 1;
+            case VegetationType::Sparse: return 2;
+            case VegetationType::Swamp: return 3;
+            case VegetationType::Forest: return 4;
+        }
+        return 5;
+    }
+
+    //  Identifies and records tiles that cannot be involved in the fire spread (e.g., water tiles and firebreaks).
     void SetProhibitedTiles() {
+        prohibitedTiles_.clear();
         for (auto& row : world_.grid) {
             for (auto& tile : row) {
-                if (tile != nullptr && tile->GetMoisture() == 100) {
+                if (tile != nullptr && (tile->GetMoisture() == 100 || fuelFactorParam_->GetValue(world_.GetTileIndex(tile)) == 0.0f)) {
                     prohibitedTiles_.push_back(tile);
                 }
             }
         }
     }
 
+    // Sets the seed of the random draws, runs with the same seed and starting tiles are identical.
+    void SetSeed(uint32_t seed) {
+        random_.SetState(seed, 0);
+    }
+
+    // Sets the weather timeline applied at the start of every update. The wind of the schedule replaces the world's wind parameters.
+    void SetWeather(WeatherSchedule weather) {
+        weather_ = std::move(weather);
+        ApplyWeather();
+    }
+
+    const WeatherSchedule& GetWeather() const {
+        return weather_;
+    }
+
+    // Sets the firefighting plan. Its actions are applied at the start of their steps, actions of steps already run are skipped.
+    void SetSuppressionPlan(SuppressionPlan plan) {
+        suppressionPlan_ = std::move(plan);
+        nextAction_ = GetFirstPendingAction();
+    }
+
+    // Applies a suppression action immediately. Only the cached spread probabilities into the edited tiles are recomputed. Tiles it
+    // extinguishes are reported by the next step, in GetLastChangedTiles and to observers, as if the action had been part of that step.
+    void ApplySuppression(const SuppressionAction& action) {
+        auto isBurningParam = world_.GetVectorParameter<bool>("isBurning");
+        auto hasBurnedParam = world_.GetVectorParameter<bool>("hasBurned");
+        std::vector<uint32_t> tiles = action.GetTiles(world_.GetWidth(), world_.GetDepth());
+
+        bool extinguished = false;
+        for (auto tileIndex : tiles) {
+            Tile* tile = world_.grid[tileIndex / world_.GetDepth()][tileIndex % world_.GetDepth()];
+            if (tile->GetMoisture() == 100) {
+                continue; // Water needs no suppression
+            }
+            switch (action.type) {
+                case SuppressionType::Firebreak:
+                    if (!isBurningParam->GetValue(tileIndex) && fuelFactorParam_->GetValue(tileIndex) != 0.0f) { // Not prohibited yet
+                        fuelFactorParam_->SetValue(tileIndex, 0.0f);
+                        prohibitedTiles_.push_back(tile);
+                    }
+                    break;
+                case SuppressionType::Retardant:
+                    fuelFactorParam_->SetValue(tileIndex, fuelFactorParam_->GetValue(tileIndex) * std::clamp(1.0f - action.strength, 0.0f, 1.0f));
+                    break;
+                case SuppressionType::Water:
+                    moistureDeltaParam_->SetValue(tileIndex, moistureDeltaParam_->GetValue(tileIndex) + static_cast<int>(std::lround(action.strength)));
+                    if (isBurningParam->GetValue(tileIndex)) {
+                        isBurningParam->SetValue(tileIndex, false);
+                        hasBurnedParam->SetValue(tileIndex, true);
+                        pendingChangedTiles_.push_back(tile);
+                        events_.BurnOut(tileIndex);
+                        extinguished = true;
+                    }
+                    break;
+            }
+        }
+
+        if (extinguished) {
+            burningTiles_.erase(std::remove_if(burningTiles_.begin(), burningTiles_.end(),
+                                               [&](Tile* tile) { return !isBurningParam->GetValue(world_.GetTileIndex(tile)); }),
+                                burningTiles_.end());
+        }
+        InvalidateSpreadTargets(tiles);
+    }
+
+    // Enables fuel drying with elapsed time and pre-heating by nearby fire.
+    void SetDrying(const FuelDryingSettings& settings) {
+        drying_ = std::make_unique<FuelDryingSettings>(settings);
+        ResetFuelMoisture();
+        InvalidateSpreadCache();
+    }
+
+    void DisableDrying() {
+        drying_.reset();
+        fuelMoisture_.clear();
+        moistureUpdatedAt_.clear();
+        preheatCount_.clear();
+        InvalidateSpreadCache();
+    }
+
+    // Enables fire spread by embers landing beyond the neighboring tiles.
+    void SetSpotting(const SpottingSettings& settings) {
+        spotting_ = std::make_unique<EmberSpotting>(settings);
+    }
+
+    void DisableSpotting() {
+        spotting_.reset();
+    }
+
+    World& GetWorld() const {
+        return world_;
+    }
+
+    // Draws the spread attempts of large fires on the scheduler, nullptr to update sequentially. Results do not depend on it. Sequential
+    // updates allocate nothing once their buffers have grown to the size of the fire (see fireSelfCheck), scheduled ones allocate their tasks.
+    void SetScheduler(TaskScheduler* scheduler) {
+        scheduler_ = scheduler;
+    }
+
     // Returns the list of tiles that are prohibited from burning.
     std::vector<Tile*> GetProhibitedTiles() const {
         return prohibitedTiles_;
     }
 
+    // Returns the tiles burning after the last update.
+    const std::vector<Tile*>& GetBurningTiles() const {
+        return burningTiles_;
+    }
+
 
 
     //  Sets up the simulation with specified starting tiles, marking them as burning.
     void Initialize(std::vector<Tile*>& startingTiles) override {
         currentTime_ = 0;
-        changesOverTime_.clear();
+        lastChangedTiles_.clear();
+        pendingChangedTiles_.clear();
+        events_.Clear();
         burningTiles_.clear();
+        ApplyWeather();
+        ResetFuelMoisture();
+        nextAction_ = 0;
+        ApplyPendingSuppression();
+        ResetEnclosedTiles();
 
         auto isBurningParam = world_.GetVectorParameter<bool>("isBurning");
+        auto ignitionTimeParam = world_.GetVectorParameter<int>("ignitionTime");
 
         for (auto& tile : startingTiles) {
                 isBurningParam->SetValue(world_.GetTileIndex(tile), true);
-                changesOverTime_[currentTime_].push_back(tile);
+                ignitionTimeParam->SetValue(world_.GetTileIndex(tile), currentTime_);
+                lastChangedTiles_.push_back(tile);
+                events_.Ignite(static_cast<uint32_t>(world_.GetTileIndex(tile)));
                 burningTiles_.push_back(tile);
         }
+        events_.Publish(currentTime_);
     }
 
     // Advances the simulation by one time step, updating the state of burning tiles and spreading fire according to various factors.
     void Update() override {
         currentTime_++; // Advance simulation time
+        random_.Advance(); // Fresh random draws for this step
+        lastChangedTiles_.clear();
+        ApplyWeather();
+        RefreshWindFactors();
+        ApplyPendingSuppression();
 
         auto isBurningParam = world_.GetVectorParameter<bool>("isBurning");
         auto hasBurnedParam = world_.GetVectorParameter<bool>("hasBurned");
         auto burningForParam = world_.GetVectorParameter<int>("burningFor");
         auto burnTimeParam = world_.GetVectorParameter<int>("burnTime");
+        auto ignitionTimeParam = world_.GetVectorParameter<int>("ignitionTime");
 
-        std::vector<Tile*> nextBurningTiles;
-        for (auto* tile : burningTiles_) {
+        nextBurningTiles_.clear();
+        auto ignite = [&](Tile* target, std::size_t targetIndex) {
+            nextBurningTiles_.push_back(target);
+            isBurningParam->SetValue(targetIndex, true);
+            ignitionTimeParam->SetValue(targetIndex, currentTime_);
+            lastChangedTiles_.push_back(target);
+            events_.Ignite(static_cast<uint32_t>(targetIndex));
+        };
+
+        float windSpeed = world_.GetParameter<float>("windSpeed")->GetValue();
+        int windDirection = world_.GetParameter<int>("windDirection")->GetValue();
+        // Draws are keyed by source and direction and, without drying and spotting, attempts do not change the state other attempts read,
+        // so they can be drawn in parallel against the state at the start of the step
+        bool parallel = scheduler_ != nullptr && !drying_ && !spotting_ && burningTiles_.size() >= ParallelBurningTiles;
+        // Without drying and weather offset the moisture bands of moistureBands_ hold, so interior tiles can check all neighbors at once
+        bool neighborKernel = !drying_ && moistureOffset_ == 0.0f;
+#if FIRESIM_X86_SIMD
+        bool useAvx2 = CpuFeatures::HasAvx2();
+#endif
+        const uint8_t* isBurning = isBurningParam->Data();
+        const uint8_t* hasBurned = hasBurnedParam->Data();
+        if (parallel) {
+            DrawSpreadAttempts(*isBurningParam, *hasBurnedParam);
+        }
+        for (std::size_t position = 0; position < burningTiles_.size(); ++position) {
+            Tile* tile = burningTiles_[position];
             std::size_t tileIndex = world_.GetTileIndex(tile);
-            auto neighbors = world_.GetNeighborTiles(tile);
-            for (auto* neighbor : neighbors) {
-                std::size_t neighborIndex = world_.GetTileIndex(neighbor);
-                if (!isBurningParam->GetValue(neighborIndex) && !hasBurnedParam->GetValue(neighborIndex) && TryIgniteTile(tile, neighbor)) {
-                    // Neighbor tile catching on fire
-                    nextBurningTiles.push_back(neighbor);
-                    isBurningParam->SetValue(neighborIndex, true);
-                    changesOverTime_[currentTime_].push_back(neighbor);
+            if (parallel) {
+                for (int direction = 0; direction < 8; ++direction) {
+                    const SpreadAttempt& attempt = spreadAttempts_[position * 8 + direction];
+                    if (attempt.target == nullptr) {
+                        break;
+                    }
+                    std::size_t neighborIndex = world_.GetTileIndex(attempt.target);
+                    if (isBurningParam->GetValue(neighborIndex)) {
+                        continue; // Ignited by an earlier source of this step, the sequential update would not have attempted it
+                    }
+                    if (attempt.computed) {
+                        StoreSpreadThreshold(attempt.slot, attempt.threshold, attempt.moistureBand);
+                    }
+                    if (attempt.ignites) {
+                        ignite(attempt.target, neighborIndex);
+                    }
+                }
+            } else if (!enclosed_[tileIndex] && neighborKernel && IsNeighborKernelTile(tile, tileIndex)) {
+                NeighborMasks masks;
+#if FIRESIM_X86_SIMD
+                masks = useAvx2 ? AttemptNeighborsAvx2(tileIndex, isBurning, hasBurned) : AttemptNeighbors(tileIndex, isBurning, hasBurned);
+#else
+                masks = AttemptNeighbors(tileIndex, isBurning, hasBurned);
+#endif
+                int x = tile->GetWidthPosition();
+                int y = tile->GetDepthPosition();
+                uint32_t ignites = masks.ignites;
+                for (uint32_t uncached = masks.unburned & ~masks.cached; uncached != 0; uncached &= uncached - 1) {
+                    int direction = __builtin_ctz(uncached);
+                    uint32_t slot = static_cast<uint32_t>(tileIndex) * 8 + direction;
+                    Tile* neighbor = world_.grid[x + NeighborDeltas[direction][0]][y + NeighborDeltas[direction][1]];
+                    if (random_.Bits(slot) < GetSpreadThreshold(tile, neighbor, slot)) {
+                        ignites |= 1u << direction;
+                    }
+                }
+                for (; ignites != 0; ignites &= ignites - 1) {
+                    int direction = __builtin_ctz(ignites); // In direction order, like the neighbor scan below
+                    ignite(world_.grid[x + NeighborDeltas[direction][0]][y + NeighborDeltas[direction][1]], tileIndex + neighborOffsets_[direction]);
                 }
+                enclosed_[tileIndex] = masks.unburned == 0;
+            } else if (!enclosed_[tileIndex]) {
+                bool enclosed = true;
+                world_.ForEachNeighborTile(tile, [&](Tile* neighbor) {
+                    std::size_t neighborIndex = world_.GetTileIndex(neighbor);
+                    if (!isBurningParam->GetValue(neighborIndex) && !hasBurnedParam->GetValue(neighborIndex)) {
+                        enclosed = false;
+                        if (TryIgniteTile(tile, neighbor)) {
+                            ignite(neighbor, neighborIndex); // Neighbor tile catching on fire
+                        }
+                    }
+                });
+                enclosed_[tileIndex] = enclosed;
+            }
+
+            if (spotting_) {
+                float fuelFactor = GetBurnTime(tile->GetVegetation()) / 4.0f; // Forests throw the most embers
+                spotting_->CastEmbers(random_, static_cast<uint32_t>(tileIndex), fuelFactor, windSpeed, windDirection,
+                                      [&](int deltaX, int deltaY, float uniform) {
+                    int x = tile->GetWidthPosition() + deltaX;
+                    int y = tile->GetDepthPosition() + deltaY;
+                    if (x < 0 || x >= world_.GetWidth() || y < 0 || y >= world_.GetDepth()) {
+                        return; // Landed outside the map
+                    }
+                    Tile* target = world_.GetTileAt(x, y);
+                    std::size_t targetIndex = world_.GetTileIndex(target);
+                    if (!isBurningParam->GetValue(targetIndex) && !hasBurnedParam->GetValue(targetIndex) &&
+                        uniform < GetSpotIgnitionProbability(target)) {
+                        ignite(target, targetIndex);
+                    }
+                });
             }
 
-            // Update burning duration
+            // Update burning duration, burned tiles keep the total number of steps they burned
             auto burningFor = burningForParam->GetValue(tileIndex) + 1;
             if (burningFor >= burnTimeParam->GetValue(tileIndex)) {
+                burningForParam->SetValue(tileIndex, burningFor);
                 isBurningParam->SetValue(tileIndex, false);
                 hasBurnedParam->SetValue(tileIndex, true);
-                changesOverTime_[currentTime_].push_back(tile);
+                lastChangedTiles_.push_back(tile);
+                events_.BurnOut(static_cast<uint32_t>(tileIndex));
             } else {
                 burningForParam->SetValue(tileIndex, burningFor);
-                nextBurningTiles.push_back(tile);
+                nextBurningTiles_.push_back(tile);
             }
         }
 
-        burningTiles_ = std::move(nextBurningTiles); // Update the list of burning tiles for the next cycle
+        burningTiles_.swap(nextBurningTiles_); // Update the list of burning tiles for the next cycle, both keep their capacity
+        events_.Publish(currentTime_);
     }
 
     // Returns whether the simulation is completed.
@@ -164,9 +468,12 @@ public:
     // Reinitializes the simulation and world parameters to their original/initial states.
     void Reset() {
         currentTime_ = 0;
-        changesOverTime_.clear();
+        lastChangedTiles_.clear();
+        pendingChangedTiles_.clear();
+        events_.Clear();
         burningTiles_.clear();
         prohibitedTiles_.clear();
+        ResetEnclosedTiles();
 
         world_.ResetParameters(); // Resets global parameters
         for (auto& row : world_.grid) {
@@ -174,16 +481,155 @@ public:
                 tile->ResetParameters(); // Resets each tile's parameters
             }
         }
+        fuelFactorParam_->Reset(); // Undoes suppression actions
+        moistureDeltaParam_->Reset();
+        nextAction_ = 0;
+        ResetFuelMoisture();
+        InvalidateSpreadCache();
+        ApplyWeather();
     }
 
 
     // Fetches the list of tiles whose state changed in the last update.
-    std::vector<Tile*> GetLastChangedTiles() const override {
-        auto it = changesOverTime_.find(currentTime_);
-        if (it != changesOverTime_.end()) {
-            return it->second;
+    const std::vector<Tile*>& GetLastChangedTiles() const override {
+        return lastChangedTiles_;
+    }
+
+    // Serializes the complete simulation state (time, random generator, wind, fire parameter planes, burning tiles and the last step's changes)
+    // into a binary blob. Restoring it into a simulation over the same world continues the run bit-identically.
+    std::vector<uint8_t> Checkpoint() const {
+        auto isBurningParam = world_.GetVectorParameter<bool>("isBurning");
+        auto hasBurnedParam = world_.GetVectorParameter<bool>("hasBurned");
+        auto burningForParam = world_.GetVectorParameter<int>("burningFor");
+        auto burnTimeParam = world_.GetVectorParameter<int>("burnTime");
+        auto ignitionTimeParam = world_.GetVectorParameter<int>("ignitionTime");
+        std::size_t totalTiles = isBurningParam->Size();
+
+        BinaryWriter writer;
+        writer.Reserve(64 + totalTiles * (2 + 4 * sizeof(int) + sizeof(float)) + burningTiles_.size() * sizeof(uint32_t));
+        writer.Write<uint32_t>(CheckpointMagic);
+        writer.Write<uint32_t>(CheckpointVersion);
+        writer.Write<int32_t>(world_.GetWidth());
+        writer.Write<int32_t>(world_.GetDepth());
+        writer.Write<int32_t>(currentTime_);
+        writer.Write<uint32_t>(random_.GetSeed());
+        writer.Write<uint64_t>(random_.GetCounter());
+        writer.Write<float>(world_.GetParameter<float>("windSpeed")->GetValue());
+        writer.Write<int32_t>(world_.GetParameter<int>("windDirection")->GetValue());
+
+        // State planes are written in bulk
+        writer.WriteBytes(isBurningParam->Data(), totalTiles);
+        writer.WriteBytes(hasBurnedParam->Data(), totalTiles);
+        writer.WriteBytes(burningForParam->Data(), totalTiles * sizeof(int));
+        writer.WriteBytes(burnTimeParam->Data(), totalTiles * sizeof(int));
+        writer.WriteBytes(ignitionTimeParam->Data(), totalTiles * sizeof(int));
+        writer.WriteBytes(fuelFactorParam_->Data(), totalTiles * sizeof(float));
+        writer.WriteBytes(moistureDeltaParam_->Data(), totalTiles * sizeof(int));
+        writer.Write<uint8_t>(drying_ ? 1 : 0);
+        if (drying_) {
+            writer.WriteBytes(fuelMoisture_.data(), totalTiles * sizeof(float));
+            writer.WriteBytes(moistureUpdatedAt_.data(), totalTiles * sizeof(int32_t));
+            writer.WriteBytes(preheatCount_.data(), totalTiles * sizeof(uint16_t));
         }
-        return std::vector<Tile*>();
+
+        // Order of the burning tiles is kept, so the next update visits them exactly as the original run would
+        WriteTileList(writer, burningTiles_);
+
+        // Changes are stored as a list of steps, of which only the current one is kept
+        writer.WriteVarUInt(1);
+        writer.Write<int32_t>(currentTime_);
+        WriteTileList(writer, lastChangedTiles_);
+        return writer.TakeBuffer();
+    }
+
+    // Replaces the simulation state with one saved by Checkpoint. Throws if the blob is malformed or was made for a world of a different size.
+    void Restore(const std::vector<uint8_t>& checkpoint) {
+        BinaryReader reader(checkpoint);
+        if (reader.Read<uint32_t>() != CheckpointMagic) {
+            throw std::runtime_error("Not a fire spread simulation checkpoint");
+        }
+        uint32_t version = reader.Read<uint32_t>();
+        if (version < 2 || version > CheckpointVersion) {
+            throw std::runtime_error("Unsupported fire spread simulation checkpoint version " + std::to_string(version));
+        }
+        if (reader.Read<int32_t>() != world_.GetWidth() || reader.Read<int32_t>() != world_.GetDepth()) {
+            throw std::runtime_error("Checkpoint was made for a world of a different size");
+        }
+
+        auto isBurningParam = world_.GetVectorParameter<bool>("isBurning");
+        auto hasBurnedParam = world_.GetVectorParameter<bool>("hasBurned");
+        auto burningForParam = world_.GetVectorParameter<int>("burningFor");
+        auto burnTimeParam = world_.GetVectorParameter<int>("burnTime");
+        auto ignitionTimeParam = world_.GetVectorParameter<int>("ignitionTime");
+        std::size_t totalTiles = isBurningParam->Size();
+
+        int currentTime = reader.Read<int32_t>();
+        uint32_t seed = reader.Read<uint32_t>();
+        uint64_t counter = reader.Read<uint64_t>();
+        float windSpeed = reader.Read<float>();
+        int windDirection = reader.Read<int32_t>();
+
+        reader.ReadBytes(isBurningParam->Data(), totalTiles);
+        reader.ReadBytes(hasBurnedParam->Data(), totalTiles);
+        reader.ReadBytes(burningForParam->Data(), totalTiles * sizeof(int));
+        reader.ReadBytes(burnTimeParam->Data(), totalTiles * sizeof(int));
+        reader.ReadBytes(ignitionTimeParam->Data(), totalTiles * sizeof(int));
+        if (version >= 3) {
+            reader.ReadBytes(fuelFactorParam_->Data(), totalTiles * sizeof(float));
+            reader.ReadBytes(moistureDeltaParam_->Data(), totalTiles * sizeof(int));
+        } else {
+            fuelFactorParam_->Reset(); // Made before suppression actions existed
+            moistureDeltaParam_->Reset();
+        }
+        std::vector<float> fuelMoisture;
+        std::vector<int32_t> moistureUpdatedAt;
+        std::vector<uint16_t> preheatCount;
+        if (version >= 4 && reader.Read<uint8_t>() != 0) {
+            fuelMoisture.resize(totalTiles);
+            moistureUpdatedAt.resize(totalTiles);
+            preheatCount.resize(totalTiles);
+            reader.ReadBytes(fuelMoisture.data(), totalTiles * sizeof(float));
+            reader.ReadBytes(moistureUpdatedAt.data(), totalTiles * sizeof(int32_t));
+            reader.ReadBytes(preheatCount.data(), totalTiles * sizeof(uint16_t));
+        }
+
+        std::vector<Tile*> burningTiles = ReadTileList(reader);
+        std::vector<Tile*> lastChangedTiles;
+        std::size_t stepCount = reader.ReadVarUInt();
+        for (std::size_t i = 0; i < stepCount; ++i) {
+            int step = reader.Read<int32_t>();
+            std::vector<Tile*> changedTiles = ReadTileList(reader);
+            if (step == currentTime) { // Older checkpoints hold the changes of all steps
+                lastChangedTiles = std::move(changedTiles);
+            }
+        }
+        if (!reader.AtEnd()) {
+            throw std::runtime_error("Checkpoint has trailing bytes");
+        }
+
+        currentTime_ = currentTime;
+        random_.SetState(seed, counter);
+        world_.GetParameter<float>("windSpeed")->SetValue(windSpeed);
+        world_.GetParameter<int>("windDirection")->SetValue(windDirection);
+        burningTiles_.assign(burningTiles.begin(), burningTiles.end()); // Copied, so the update buffers keep their capacity
+        lastChangedTiles_.assign(lastChangedTiles.begin(), lastChangedTiles.end());
+        pendingChangedTiles_.clear();
+        events_.Clear();
+        moistureOffset_ = weather_.Sample(currentTime_).moistureOffset;
+        nextAction_ = GetFirstPendingAction();
+        SetProhibitedTiles(); // Firebreaks of the restored state
+        ResetEnclosedTiles(); // Found again by the next update
+        if (drying_) {
+            if (fuelMoisture.empty()) {
+                ResetFuelMoisture(); // Saved without drying, tiles start drying from now
+                std::fill(moistureUpdatedAt_.begin(), moistureUpdatedAt_.end(), currentTime_);
+            } else {
+                fuelMoisture_ = std::move(fuelMoisture);
+                moistureUpdatedAt_ = std::move(moistureUpdatedAt);
+                preheatCount_ = std::move(preheatCount);
+            }
+        }
+        InvalidateSpreadCache();
     }
 
     // Provides a mapping of tile indices to their corresponding colors based on their current state, aiding in visualization.
@@ -192,34 +638,360 @@ public:
         for (const auto& tile : GetLastChangedTiles()) {
             std::size_t tileIndex = world_.GetTileIndex(tile); // Logic to get tile's index in the visualizer
             // Determine color based on tile properties
-            sf::Color color = world_.GetVectorParameter<bool>("isBurning")->GetValue(tileIndex)? sf::Color(255, 105, 105) : sf::Color(180, 50, 50);
-            tileColors[tileIndex] = color;
+            bool isBurning = world_.GetVectorParameter<bool>("isBurning")->GetValue(tileIndex);
+            tileColors[tileIndex] = GetTileStateColor(isBurning ? TileState::Burning : TileState::Burned);
         }
         return tileColors;
     }
 
+    // Colors used to show burning and burned tiles, shared with anything that replays fire state (e.g. ReplayPlayer).
+    static sf::Color GetTileStateColor(TileState state) {
+        return state == TileState::Burning ? sf::Color(255, 105, 105) : sf::Color(180, 50, 50);
+    }
+
+
+    static constexpr uint32_t CheckpointMagic = 0x50435346; // "FSCP"
+    static constexpr uint32_t CheckpointVersion = 4; // 3 added the suppression planes, 4 the fuel drying state
+
+    void WriteTileList(BinaryWriter& writer, const std::vector<Tile*>& tiles) const {
+        writer.WriteVarUInt(tiles.size());
+        for (auto* tile : tiles) {
+            writer.Write<uint32_t>(static_cast<uint32_t>(world_.GetTileIndex(tile)));
+        }
+    }
+
+    std::vector<Tile*> ReadTileList(BinaryReader& reader) const {
+        std::size_t count = reader.ReadVarUInt();
+        if (count > reader.Remaining() / sizeof(uint32_t)) {
+            throw std::runtime_error("Malformed tile list in checkpoint");
+        }
+        std::vector<Tile*> tiles;
+        tiles.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            uint32_t tileIndex = reader.Read<uint32_t>();
+            tiles.push_back(world_.GetTileAt(static_cast<int>(tileIndex / world_.GetDepth()), static_cast<int>(tileIndex % world_.GetDepth())));
+        }
+        return tiles;
+    }
 
     // Determines whether a target tile will ignite from a source tile based on the calculated spread probability, simulating randomness with a range comparison.
+    // Each source and direction has its own draw in every step, so the result does not depend on the order in which burning tiles are processed.
     bool TryIgniteTile(Tile* source, Tile* target) {
-        float spreadProbability = CalculateFireSpreadProbability(source, target);
-        return Random::Range(0.0f, 1.0f) < spreadProbability;
+        auto [deltaX, deltaY] = world_.GetTilesDistanceXY(target, source);
+        uint32_t slot = static_cast<uint32_t>(world_.GetTileIndex(source)) * 8 + GetDirectionIndex(deltaX, deltaY);
+        bool ignites = random_.Bits(slot) < GetSpreadThreshold(source, target, slot);
+        if (drying_ && !ignites) {
+            std::size_t targetIndex = world_.GetTileIndex(target);
+            UpdateFuelMoisture(targetIndex);
+            preheatCount_[targetIndex]++; // Dries the tile from the next step on, so attempts of one step do not depend on their order
+        }
+        return ignites;
+    }
+
+    // Whether the tile's neighbor attempts can go through AttemptNeighbors: all eight neighbors exist, and the 4-byte gathers of the AVX2
+    // version at the last neighbor stay inside the planes.
+    bool IsNeighborKernelTile(Tile* tile, std::size_t tileIndex) const {
+        int x = tile->GetWidthPosition();
+        int y = tile->GetDepthPosition();
+        return x > 0 && y > 0 && x + 1 < world_.GetWidth() && y + 1 < world_.GetDepth() &&
+               tileIndex + world_.GetDepth() + 4 < moistureBands_.size();
+    }
+
+    // Attempts of an interior tile on its eight neighbors with the cached thresholds, the same draws and decisions as TryIgniteTile without
+    // drying. Attempts without a valid cache entry are left to the caller. Only reads the simulation, so results do not depend on the version.
+    FIRESIM_INLINE NeighborMasks AttemptNeighbors(std::size_t tileIndex, const uint8_t* isBurning, const uint8_t* hasBurned) const {
+        NeighborMasks masks{0, 0, 0};
+        uint32_t firstSlot = static_cast<uint32_t>(tileIndex) * 8;
+        for (int direction = 0; direction < 8; ++direction) {
+            std::size_t neighborIndex = tileIndex + neighborOffsets_[direction];
+            if (isBurning[neighborIndex] | hasBurned[neighborIndex]) {
+                continue;
+            }
+            uint32_t bit = 1u << direction;
+            uint32_t slot = firstSlot + direction;
+            masks.unburned |= bit;
+            uint32_t computedAt = spreadComputedAt_[slot];
+            if (computedAt != 0 && computedAt >= windChangedAt_[direction] && spreadMoistureBand_[slot] == moistureBands_[neighborIndex]) {
+                masks.cached |= bit;
+                masks.ignites |= random_.Bits(slot) < spreadThresholds_[slot] ? bit : 0;
+            }
+        }
+        return masks;
+    }
+
+#if FIRESIM_X86_SIMD
+    // AVX2 version of AttemptNeighbors: gathers the neighbor flags and moisture bands, draws the eight slots and compares them with the
+    // eight thresholds in one vector each.
+    FIRESIM_TARGET_AVX2 NeighborMasks AttemptNeighborsAvx2(std::size_t tileIndex, const uint8_t* isBurning, const uint8_t* hasBurned) const {
+        const __m256i byteMask = _mm256_set1_epi32(0xff);
+        const __m256i signBit = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+        __m256i neighbors = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(tileIndex)),
+                                             _mm256_loadu_si256(reinterpret_cast<const __m256i*>(neighborOffsets_)));
+        __m256i flags = _mm256_or_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(isBurning), neighbors, 1),
+                                        _mm256_i32gather_epi32(reinterpret_cast<const int*>(hasBurned), neighbors, 1));
+        __m256i unburned = _mm256_cmpeq_epi32(_mm256_and_si256(flags, byteMask), _mm256_setzero_si256());
+
+        std::size_t firstSlot = tileIndex * 8;
+        __m256i computedAt = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(spreadComputedAt_.data() + firstSlot));
+        __m256i windChangedAt = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(windChangedAt_));
+        __m256i cached = _mm256_andnot_si256(_mm256_cmpeq_epi32(computedAt, _mm256_setzero_si256()),
+                                             _mm256_cmpeq_epi32(_mm256_max_epu32(computedAt, windChangedAt), computedAt));
+        __m256i bands = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(moistureBands_.data()), neighbors, 1), byteMask);
+        __m256i cachedBands = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(spreadMoistureBand_.data() + firstSlot)));
+        cached = _mm256_and_si256(_mm256_and_si256(cached, unburned), _mm256_cmpeq_epi32(bands, cachedBands));
+
+        // CounterRandom::Bits of the eight slots
+        __m256i draws = _mm256_xor_si256(_mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(firstSlot)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)),
+                                         _mm256_set1_epi32(static_cast<int>(random_.GetStreamKey())));
+        draws = _mm256_xor_si256(draws, _mm256_srli_epi32(draws, 16));
+        draws = _mm256_mullo_epi32(draws, _mm256_set1_epi32(static_cast<int>(0x85ebca6bu)));
+        draws = _mm256_xor_si256(draws, _mm256_srli_epi32(draws, 13));
+        draws = _mm256_mullo_epi32(draws, _mm256_set1_epi32(static_cast<int>(0xc2b2ae35u)));
+        draws = _mm256_xor_si256(draws, _mm256_srli_epi32(draws, 16));
+        __m256i thresholds = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(spreadThresholds_.data() + firstSlot));
+        __m256i below = _mm256_cmpgt_epi32(_mm256_xor_si256(thresholds, signBit), _mm256_xor_si256(draws, signBit)); // Unsigned draw < threshold
+
+        NeighborMasks masks;
+        masks.unburned = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(unburned)));
+        masks.cached = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(cached)));
+        masks.ignites = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(cached, below))));
+        return masks;
+    }
+#endif
+
+    // Fills spreadAttempts_ with the attempts of every burning tile on its neighbors that are neither burning nor burned, drawing the tiles in
+    // parallel. Cache entries are only read here, the sequential part stores the ones of attempts it applies.
+    void DrawSpreadAttempts(const TypedVectorParameter<bool>& isBurning, const TypedVectorParameter<bool>& hasBurned) {
+        spreadAttempts_.assign(burningTiles_.size() * 8, SpreadAttempt{});
+        scheduler_->ParallelFor(0, burningTiles_.size(), 256, [&](std::size_t from, std::size_t to) {
+            for (std::size_t position = from; position < to; ++position) {
+                Tile* tile = burningTiles_[position];
+                std::size_t tileIndex = world_.GetTileIndex(tile);
+                if (enclosed_[tileIndex]) {
+                    continue;
+                }
+                SpreadAttempt* attempt = &spreadAttempts_[position * 8];
+                world_.ForEachNeighborTile(tile, [&](Tile* neighbor) {
+                    std::size_t neighborIndex = world_.GetTileIndex(neighbor);
+                    if (isBurning.GetValue(neighborIndex) || hasBurned.GetValue(neighborIndex)) {
+                        return;
+                    }
+                    auto [deltaX, deltaY] = world_.GetTilesDistanceXY(neighbor, tile);
+                    uint32_t slot = static_cast<uint32_t>(tileIndex) * 8 + GetDirectionIndex(deltaX, deltaY);
+                    attempt->target = neighbor;
+                    attempt->slot = slot;
+                    attempt->moistureBand = GetMoistureBand(GetEffectiveMoisture(neighbor));
+                    attempt->computed = !IsSpreadThresholdCached(slot, attempt->moistureBand);
+                    attempt->threshold =
+                            attempt->computed ? CounterRandom::Threshold(CalculateFireSpreadProbability(tile, neighbor)) : spreadThresholds_[slot];
+                    attempt->ignites = random_.Bits(slot) < attempt->threshold;
+                    attempt++;
+                });
+                enclosed_[tileIndex] = attempt == &spreadAttempts_[position * 8]; // Every task writes the flags of its own tiles only
+            }
+        });
+    }
+
+    // Forgets which burning tiles are enclosed, e.g. after the state was replaced. Updates find them again on their next neighbor scan.
+    void ResetEnclosedTiles() {
+        enclosed_.assign(static_cast<std::size_t>(world_.GetWidth()) * world_.GetDepth(), 0);
+    }
+
+    // Cached threshold of CalculateFireSpreadProbability of the source tile and direction slot.
+    uint32_t GetSpreadThreshold(Tile* source, Tile* target, uint32_t slot) {
+        uint8_t moistureBand = GetMoistureBand(GetEffectiveMoisture(target));
+        if (!IsSpreadThresholdCached(slot, moistureBand)) {
+            StoreSpreadThreshold(slot, CounterRandom::Threshold(CalculateFireSpreadProbability(source, target)), moistureBand);
+        }
+        return spreadThresholds_[slot];
+    }
+
+    bool IsSpreadThresholdCached(uint32_t slot, uint8_t moistureBand) const {
+        uint32_t computedAt = spreadComputedAt_[slot];
+        return computedAt != 0 && computedAt >= windChangedAt_[slot % 8] && spreadMoistureBand_[slot] == moistureBand;
+    }
+
+    void StoreSpreadThreshold(uint32_t slot, uint32_t threshold, uint8_t moistureBand) {
+        spreadThresholds_[slot] = threshold;
+        spreadComputedAt_[slot] = spreadEpoch_;
+        spreadMoistureBand_[slot] = moistureBand;
+    }
+
+    // Drops all cached spread probabilities, e.g. after the terrain or the whole state changed.
+    void InvalidateSpreadCache() {
+        std::size_t totalTiles = static_cast<std::size_t>(world_.GetWidth()) * world_.GetDepth();
+        spreadThresholds_.assign(totalTiles * 8, 0);
+        spreadComputedAt_.assign(totalTiles * 8, 0);
+        spreadMoistureBand_.assign(totalTiles * 8, 0);
+        spreadEpoch_ = 1;
+        std::fill(std::begin(windChangedAt_), std::end(windChangedAt_), 1);
+        moistureBands_.resize(totalTiles);
+        for (std::size_t tileIndex = 0; tileIndex < totalTiles; ++tileIndex) {
+            UpdateMoistureBand(tileIndex);
+        }
+        for (int direction = 0; direction < 8; ++direction) {
+            neighborOffsets_[direction] = NeighborDeltas[direction][0] * world_.GetDepth() + NeighborDeltas[direction][1];
+        }
+        cachedWindSpeed_ = -1.0f;
+        cachedWindDirection_ = -1;
+        RefreshWindFactors();
+    }
+
+    // Recomputes the wind factor of the 8 directions if the wind changed (by the weather schedule or from outside) and marks only the
+    // directions whose factor actually changed, e.g. a stronger wind leaves the upwind directions and a capped downwind factor untouched.
+    void RefreshWindFactors() {
+        float windSpeed = world_.GetParameter<float>("windSpeed")->GetValue();
+        int windDirection = world_.GetParameter<int>("windDirection")->GetValue();
+        if (windSpeed == cachedWindSpeed_ && windDirection == cachedWindDirection_) {
+            return;
+        }
+        cachedWindSpeed_ = windSpeed;
+        cachedWindDirection_ = windDirection;
+
+        spreadEpoch_++;
+        for (int direction = 0; direction < 8; ++direction) {
+            float windFactor = GetWindFactor(windSpeed, windDirection, static_cast<float>(NeighborDeltas[direction][0]),
+                                             static_cast<float>(NeighborDeltas[direction][1]), 1.0f);
+            if (windFactor != windFactors_[direction]) {
+                windFactors_[direction] = windFactor;
+                windChangedAt_[direction] = spreadEpoch_;
+            }
+        }
+    }
+
+    // Sets the wind and moisture offset of the current step from the weather schedule, if there is one.
+    void ApplyWeather() {
+        if (weather_.IsEmpty()) {
+            moistureOffset_ = 0.0f;
+            return;
+        }
+        WeatherState state = weather_.Sample(currentTime_);
+        world_.GetParameter<float>("windSpeed")->SetValue(state.windSpeed);
+        world_.GetParameter<int>("windDirection")->SetValue(state.windDirection);
+        moistureOffset_ = state.moistureOffset;
+    }
+
+    // Moisture of the tile after the weather's drying or wetting. Water stays water.
+    int GetEffectiveMoisture(Tile* tile) {
+        int moisture = tile->GetMoisture();
+        std::size_t tileIndex = world_.GetTileIndex(tile);
+        int delta = moistureDeltaParam_->GetValue(tileIndex);
+        if (moisture == 100 || (moistureOffset_ == 0.0f && delta == 0 && !drying_)) {
+            return moisture;
+        }
+        float fuelMoisture = drying_ ? UpdateFuelMoisture(tileIndex) : static_cast<float>(moisture);
+        return std::clamp(static_cast<int>(std::lround(fuelMoisture + delta - moistureOffset_)), 0, 99);
+    }
+
+    // Brings the drying of the tile forward to the current step: first the pre-heating of its last step, then the exponential drying of the
+    // steps since. Returns the tile's fuel moisture before the drying by weather and suppression.
+    float UpdateFuelMoisture(std::size_t tileIndex) {
+        int elapsed = currentTime_ - moistureUpdatedAt_[tileIndex];
+        if (elapsed > 0) {
+            float moisture = std::max(0.0f, fuelMoisture_[tileIndex] - drying_->preheat * preheatCount_[tileIndex]);
+            float remaining = std::pow(1.0f - drying_->dryingRate, static_cast<float>(elapsed));
+            fuelMoisture_[tileIndex] = drying_->equilibriumMoisture + (moisture - drying_->equilibriumMoisture) * remaining;
+            moistureUpdatedAt_[tileIndex] = currentTime_;
+            preheatCount_[tileIndex] = 0;
+        }
+        return fuelMoisture_[tileIndex];
+    }
+
+    // Starts every tile's fuel moisture at its terrain moisture.
+    void ResetFuelMoisture() {
+        if (!drying_) {
+            return;
+        }
+        std::size_t totalTiles = static_cast<std::size_t>(world_.GetWidth()) * world_.GetDepth();
+        fuelMoisture_.resize(totalTiles);
+        for (int x = 0; x < world_.GetWidth(); ++x) {
+            for (int y = 0; y < world_.GetDepth(); ++y) {
+                fuelMoisture_[static_cast<std::size_t>(x) * world_.GetDepth() + y] = static_cast<float>(world_.grid[x][y]->GetMoisture());
+            }
+        }
+        moistureUpdatedAt_.assign(totalTiles, 0);
+        preheatCount_.assign(totalTiles, 0);
+    }
+
+    // Applies the actions of the suppression plan that are due in the current step and adds the tiles changed by suppression since the
+    // last step to the changes of this one.
+    void ApplyPendingSuppression() {
+        const auto& actions = suppressionPlan_.GetActions();
+        for (; nextAction_ < actions.size() && actions[nextAction_].step <= currentTime_; ++nextAction_) {
+            ApplySuppression(actions[nextAction_]);
+        }
+        lastChangedTiles_.insert(lastChangedTiles_.end(), pendingChangedTiles_.begin(), pendingChangedTiles_.end());
+        pendingChangedTiles_.clear();
+    }
+
+    std::size_t GetFirstPendingAction() const {
+        const auto& actions = suppressionPlan_.GetActions();
+        std::size_t index = 0;
+        while (index < actions.size() && actions[index].step <= currentTime_) {
+            index++;
+        }
+        return index;
+    }
+
+    // Drops the cached spread probabilities into the given tiles, i.e. of their neighbors in the direction of the tile.
+    void InvalidateSpreadTargets(const std::vector<uint32_t>& tileIndices) {
+        int depth = world_.GetDepth();
+        for (auto tileIndex : tileIndices) {
+            int x = static_cast<int>(tileIndex) / depth;
+            int y = static_cast<int>(tileIndex) % depth;
+            for (int deltaX = -1; deltaX <= 1; ++deltaX) {
+                for (int deltaY = -1; deltaY <= 1; ++deltaY) {
+                    int sourceX = x - deltaX;
+                    int sourceY = y - deltaY;
+                    if ((deltaX == 0 && deltaY == 0) || sourceX < 0 || sourceX >= world_.GetWidth() || sourceY < 0 || sourceY >= depth) {
+                        continue;
+                    }
+                    spreadComputedAt_[static_cast<std::size_t>(sourceX * depth + sourceY) * 8 + GetDirectionIndex(deltaX, deltaY)] = 0;
+                }
+            }
+            UpdateMoistureBand(tileIndex);
+        }
+    }
+
+    // Sets the tile's entry of moistureBands_, GetEffectiveMoisture without drying and weather offset.
+    void UpdateMoistureBand(std::size_t tileIndex) {
+        int moisture = world_.grid[tileIndex / world_.GetDepth()][tileIndex % world_.GetDepth()]->GetMoisture();
+        int delta = moistureDeltaParam_->GetValue(tileIndex);
+        moistureBands_[tileIndex] = GetMoistureBand(moisture == 100 || delta == 0 ? moisture : std::clamp(moisture + delta, 0, 99));
+    }
+
+    // Chance that an ember landing on the tile ignites it, water gives 0.
+    float GetSpotIgnitionProbability(Tile* target) {
+        return spotting_->GetSettings().ignitionFactor * GetVegetationFactor(target->GetVegetation(), 1.0f) *
+               GetMoistureFactor(GetEffectiveMoisture(target), 1.0f) * fuelFactorParam_->GetValue(world_.GetTileIndex(target));
+    }
+
+    // Band of GetMoistureFactor the moisture falls into, the factor is the same for all moistures of a band.
+    static uint8_t GetMoistureBand(int moisture) {
+        return moisture == 100 ? 0 : moisture > 85 ? 1 : moisture > 65 ? 2 : 3;
+    }
+
+    // Index 0-7 of the direction to one of the eight neighbors.
+    static int GetDirectionIndex(int deltaX, int deltaY) {
+        int index = (deltaX + 1) * 3 + (deltaY + 1);
+        return index > 4 ? index - 1 : index;
     }
 
     // Integrates various environmental and situational factors to compute the overall probability of fire spreading from one tile to another.
     float CalculateFireSpreadProbability(Tile* source, Tile* target) {
         float vegetationFactor = GetVegetationFactor(target->GetVegetation(), 1.0f);
-        float moistureFactor = GetMoistureFactor(target->GetMoisture(), 1.0f);
+        float moistureFactor = GetMoistureFactor(GetEffectiveMoisture(target), 1.0f);
         float windFactor = GetWindFactor(world_, source, target,1.0f);
         float slopeFactor = GetSlopeFactor(source, target, 1.0f);
 
         float combined = (vegetationFactor + slopeFactor) / 2;
-        float adjustedProbability = combined * moistureFactor * windFactor;
+        float adjustedProbability = combined * moistureFactor * windFactor * fuelFactorParam_->GetValue(world_.GetTileIndex(target));
 
         return GetStepProbability(adjustedProbability, world_.GetVectorParameter<int>("burnTime")->GetValue(source->GetWidthPosition() * world_.GetDepth() + source->GetDepthPosition()));
     }
 
     // Helper methods for factor calculations
-    float GetVegetationFactor(VegetationType vegetation, float spreadFactor) {
+    static float GetVegetationFactor(VegetationType vegetation, float spreadFactor) {
         float factor = 1.0f;
         switch (vegetation) {
             case VegetationType::Grass: factor = 0.18f; break;
@@ -231,7 +1003,7 @@ public:
     }
 
     // Helper methods for factor calculations
-    float GetMoistureFactor(int moisture, float spreadFactor) {
+    static float GetMoistureFactor(int moisture, float spreadFactor) {
         if (moisture == 100) {
             return 0; // water tile
         }
@@ -246,13 +1018,18 @@ public:
     }
 
     // Helper methods for factor calculations
-    float GetWindFactor(World& world, Tile* source, Tile* target, float spreadFactor) {
+    static float GetWindFactor(World& world, Tile* source, Tile* target, float spreadFactor) {
         auto windSpeed = world.GetParameter<float>("windSpeed")->GetValue();
         auto windDirection = world.GetParameter<int>("windDirection")->GetValue();
 
         // Calculate direction from source to target tile
         float deltaX = target->GetWidthPosition() - source->GetWidthPosition();
         float deltaY = target->GetDepthPosition() - source->GetDepthPosition();
+        return GetWindFactor(windSpeed, windDirection, deltaX, deltaY, spreadFactor);
+    }
+
+    // Wind factor for spreading in the direction (deltaX, deltaY) under the given wind.
+    static float GetWindFactor(float windSpeed, int windDirection, float deltaX, float deltaY, float spreadFactor) {
         float angleToTarget = std::atan2(deltaY, deltaX) * (180 / M_PI);
         if (angleToTarget < 0) {
             angleToTarget += 360; // Normalize angle to 0-359 degrees
@@ -279,7 +1056,7 @@ public:
     }
 
     // Helper methods for factor calculations
-    float GetSlopeFactor(Tile* source, Tile* target, float spreadFactor) {
+    static float GetSlopeFactor(Tile* source, Tile* target, float spreadFactor) {
         float slopeDifference = target->GetHeight() - source->GetHeight();
         if (slopeDifference >= 0) {
             return 0.35f * spreadFactor;
@@ -0,0 +1,136 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Compact per-tile fire state, used where the whole state of a tile has to be stored or sent in one value (recordings, exports).
+enum class TileState : uint8_t {
+    Unburned = 0,
+    Burning = 1,
+    Burned = 2
+};
+
+// Events an observer can subscribe to, combined as a mask.
+enum SimulationEvent : uint32_t {
+    IgnitionEvents = 1,
+    BurnoutEvents = 2,
+    StepCompletedEvents = 4,
+    AllSimulationEvents = IgnitionEvents | BurnoutEvents | StepCompletedEvents
+};
+
+// Tile changes of one step, collected while the simulation runs it. Tile indices are x * depth + y.
+struct StepChanges {
+    int step = 0;
+    std::vector<uint32_t> tiles; // Every change in the order the simulation made it, a tile changing twice appears twice
+    std::vector<TileState> states; // New state of the tile of the same entry of tiles
+    std::vector<uint32_t> ignitions; // Tiles that caught fire
+    std::vector<uint32_t> burnouts; // Tiles that burned out or were put out
+};
+
+// Receives the changes of a simulation once per step (step 0 being Initialize), see Simulation::Subscribe. Batches are passed by reference
+// and only valid during the call. Callbacks run on the thread calling Initialize or Update and must not subscribe or unsubscribe.
+class SimulationObserver {
+public:
+    virtual ~SimulationObserver() = default;
+
+    // Tiles that caught fire in the step, not called for steps without ignitions.
+    virtual void OnIgnitions(int, const std::vector<uint32_t>&) {}
+
+    // Tiles that burned out in the step, not called for steps without burnouts.
+    virtual void OnBurnouts(int, const std::vector<uint32_t>&) {}
+
+    // All changes of the step, called after the other events of the step, also if nothing changed.
+    virtual void OnStepCompleted(const StepChanges&) {}
+};
+
+// Observers of a simulation and the changes of its current step. Nothing is collected while there are no observers.
+class SimulationEvents {
+    struct Subscription {
+        SimulationObserver* observer;
+        uint32_t events;
+    };
+
+    std::vector<Subscription> subscriptions_;
+    StepChanges changes_;
+
+public:
+    // Adds the observer for the given events, or changes its events if it is already subscribed.
+    void Subscribe(SimulationObserver& observer, uint32_t events) {
+        for (auto& subscription : subscriptions_) {
+            if (subscription.observer == &observer) {
+                subscription.events = events;
+                return;
+            }
+        }
+        subscriptions_.push_back({&observer, events});
+    }
+
+    void Unsubscribe(SimulationObserver& observer) {
+        subscriptions_.erase(std::remove_if(subscriptions_.begin(), subscriptions_.end(),
+                                            [&](const Subscription& subscription) { return subscription.observer == &observer; }),
+                             subscriptions_.end());
+        if (subscriptions_.empty()) {
+            Clear();
+        }
+    }
+
+    bool HasObservers() const {
+        return !subscriptions_.empty();
+    }
+
+    void Ignite(uint32_t tile) {
+        if (HasObservers()) {
+            Add(tile, TileState::Burning);
+            changes_.ignitions.push_back(tile);
+        }
+    }
+
+    void BurnOut(uint32_t tile) {
+        if (HasObservers()) {
+            Add(tile, TileState::Burned);
+            changes_.burnouts.push_back(tile);
+        }
+    }
+
+    // Any other change, e.g. a tile whose state is set back when going back in time.
+    void Change(uint32_t tile, TileState state) {
+        if (HasObservers()) {
+            Add(tile, state);
+        }
+    }
+
+    // Sends the changes collected since the last publication as the given step and starts collecting the next ones. Changes made between
+    // steps (e.g. a suppression action applied from outside) are published with the next step.
+    void Publish(int step) {
+        if (!HasObservers()) {
+            return;
+        }
+        changes_.step = step;
+        for (const auto& subscription : subscriptions_) {
+            if ((subscription.events & IgnitionEvents) && !changes_.ignitions.empty()) {
+                subscription.observer->OnIgnitions(step, changes_.ignitions);
+            }
+            if ((subscription.events & BurnoutEvents) && !changes_.burnouts.empty()) {
+                subscription.observer->OnBurnouts(step, changes_.burnouts);
+            }
+            if (subscription.events & StepCompletedEvents) {
+                subscription.observer->OnStepCompleted(changes_);
+            }
+        }
+        Clear();
+    }
+
+    // Drops the changes collected so far, e.g. when the simulation is reset.
+    void Clear() {
+        changes_.tiles.clear();
+        changes_.states.clear();
+        changes_.ignitions.clear();
+        changes_.burnouts.clear();
+    }
+
+private:
+    void Add(uint32_t tile, TileState state) {
+        changes_.tiles.push_back(tile);
+        changes_.states.push_back(state);
+    }
+};
@@ -0,0 +1,369 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "binaryIO.h"
+#include "scenarioRunner.h"
+
+// Framing of the simulation service. Every frame is a type byte and a uint32 payload size (host byte order, client and service share the
+// machine) followed by the payload. A client sends one Request with the text of a single scenario (scenario.h format) and receives Started,
+// one Step frame per step (step 0 holds the ignitions) and Finished, or an Error at any point, after which the service closes the connection.
+enum class ServiceFrame : uint8_t {
+    Request = 1,  // Scenario text
+    Started = 2,  // varuint width, varuint depth, uint8 world was cached
+    Step = 3,     // varuint step, varuint change count, per change varuint (tile index delta << 2 | TileState), tiles in ascending order
+    Finished = 4, // varuint steps, varuint burned tiles, varuint burning tiles, uint8 fire is out
+    Error = 5     // Message text
+};
+
+// Tile changes of one step, as carried by a Step frame.
+struct ServiceStep {
+    int step = 0;
+    std::vector<std::pair<uint32_t, TileState>> changes; // Tile index (x * depth + y) and new state
+
+    std::vector<uint8_t> Encode() const {
+        BinaryWriter writer;
+        writer.Reserve(changes.size() * 2 + 8);
+        writer.WriteVarUInt(static_cast<uint64_t>(step));
+        writer.WriteVarUInt(changes.size());
+        uint32_t previous = 0;
+        for (const auto& [tile, state] : changes) {
+            writer.WriteVarUInt(static_cast<uint64_t>(tile - previous) << 2 | static_cast<uint8_t>(state));
+            previous = tile;
+        }
+        return writer.TakeBuffer();
+    }
+
+    static ServiceStep Decode(const std::vector<uint8_t>& payload) {
+        BinaryReader reader(payload);
+        ServiceStep step;
+        step.step = static_cast<int>(reader.ReadVarUInt());
+        uint64_t count = reader.ReadVarUInt();
+        uint32_t tile = 0;
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t value = reader.ReadVarUInt();
+            tile += static_cast<uint32_t>(value >> 2);
+            step.changes.emplace_back(tile, static_cast<TileState>(value & 3));
+        }
+        return step;
+    }
+};
+
+// Stream socket carrying service frames, closed with the object.
+class ServiceConnection {
+    int socket_;
+
+public:
+    explicit ServiceConnection(int socket) : socket_(socket) {}
+
+    // Connects to the service listening at the given socket path.
+    static ServiceConnection Connect(const std::string& path) {
+        sockaddr_un address = MakeAddress(path);
+        int socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (socket < 0) {
+            throw std::system_error(errno, std::generic_category(), "Cannot create socket");
+        }
+        ServiceConnection connection(socket);
+        if (connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Cannot connect to " + path);
+        }
+        return connection;
+    }
+
+    ~ServiceConnection() {
+        if (socket_ >= 0) {
+            close(socket_);
+        }
+    }
+
+    ServiceConnection(ServiceConnection&& other) noexcept : socket_(other.socket_) {
+        other.socket_ = -1;
+    }
+
+    ServiceConnection(const ServiceConnection&) = delete;
+    ServiceConnection& operator=(const ServiceConnection&) = delete;
+
+    // Gives up on sends and receives that make no progress for the given time, 0 waits forever.
+    void SetTimeout(int seconds) {
+        timeval timeout{seconds, 0};
+        setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(socket_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+
+    void Send(ServiceFrame type, const void* payload, std::size_t size) {
+        if (size > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("Service frame too large");
+        }
+        uint8_t header[5];
+        header[0] = static_cast<uint8_t>(type);
+        uint32_t payloadSize = static_cast<uint32_t>(size);
+        std::memcpy(header + 1, &payloadSize, sizeof(payloadSize));
+        SendAll(header, sizeof(header));
+        SendAll(payload, size);
+    }
+
+    void Send(ServiceFrame type, const std::vector<uint8_t>& payload) {
+        Send(type, payload.data(), payload.size());
+    }
+
+    void Send(ServiceFrame type, const std::string& text) {
+        Send(type, text.data(), text.size());
+    }
+
+    // Reads the next frame. Returns false if the peer closed the connection between frames; throws on errors, timeouts and payloads larger
+    // than maxSize.
+    bool Receive(ServiceFrame& type, std::vector<uint8_t>& payload, std::size_t maxSize = std::numeric_limits<uint32_t>::max()) {
+        uint8_t header[5];
+        if (!ReceiveAll(header, sizeof(header), true)) {
+            return false;
+        }
+        uint32_t size;
+        std::memcpy(&size, header + 1, sizeof(size));
+        if (size > maxSize) {
+            throw std::length_error("Service frame of " + std::to_string(size) + " bytes exceeds the limit");
+        }
+        type = static_cast<ServiceFrame>(header[0]);
+        payload.resize(size);
+        ReceiveAll(payload.data(), size, false);
+        return true;
+    }
+
+    static sockaddr_un MakeAddress(const std::string& path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Invalid socket path: " + path);
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return address;
+    }
+
+private:
+    void SendAll(const void* data, std::size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t sent = send(socket_, bytes, size, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "Cannot send service frame");
+            }
+            bytes += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+    }
+
+    // Returns false if the connection was closed before the first byte and endAllowed is set.
+    bool ReceiveAll(void* data, std::size_t size, bool endAllowed) {
+        char* bytes = static_cast<char*>(data);
+        std::size_t received = 0;
+        while (received < size) {
+            ssize_t count = recv(socket_, bytes + received, size - received, 0);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "Cannot receive service frame");
+            }
+            if (count == 0) {
+                if (endAllowed && received == 0) {
+                    return false;
+                }
+                throw std::runtime_error("Connection closed within a service frame");
+            }
+            received += static_cast<std::size_t>(count);
+        }
+        return true;
+    }
+};
+
+// Settings of the simulation service.
+struct ServiceSettings {
+    std::size_t threads = std::thread::hardware_concurrency();
+    std::size_t maxQueuedRuns = 64;     // Runs admitted beyond one per thread; further requests are rejected right away
+    std::size_t cachedWorlds = 16;
+    int timeoutSeconds = 10;            // Clients that send nothing or stop reading for this long are dropped
+    std::size_t maxRequestSize = 1 << 20;
+};
+
+// Long-running simulation service on a Unix domain socket. Generated worlds stay in a WorldCache, so requests for known worlds only copy
+// the terrain, and every connection runs as a task on one shared TaskScheduler. Admission control bounds the runs in flight (running plus
+// queued); a request beyond that gets an Error frame at once instead of waiting. Each step's changes are sent as soon as the step is done.
+class SimulationService {
+    std::string socketPath_;
+    ServiceSettings settings_;
+    TaskScheduler scheduler_;
+    WorldCache worldCache_;
+    int listener_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::atomic<std::size_t> admittedRuns_{0};
+    TaskGroup runs_;
+
+public:
+    // Listens at the socket path. A stale socket file left by a previous service is replaced, any other file is an error.
+    SimulationService(const std::string& socketPath, ServiceSettings settings)
+            : socketPath_(socketPath), settings_(settings), scheduler_(settings.threads), worldCache_(settings.cachedWorlds, &scheduler_) {
+        sockaddr_un address = ServiceConnection::MakeAddress(socketPath_);
+        struct stat status;
+        if (lstat(socketPath_.c_str(), &status) == 0) {
+            if (!S_ISSOCK(status.st_mode)) {
+                throw std::runtime_error(socketPath_ + " exists and is not a socket");
+            }
+            unlink(socketPath_.c_str());
+        }
+
+        listener_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listener_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "Cannot create socket");
+        }
+        if (bind(listener_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener_, 128) != 0) {
+            int error = errno;
+            close(listener_);
+            throw std::system_error(error, std::generic_category(), "Cannot listen at " + socketPath_);
+        }
+    }
+
+    // Stops accepting, aborts the running requests and removes the socket file.
+    ~SimulationService() {
+        Stop();
+        scheduler_.Wait(runs_);
+        close(listener_);
+        unlink(socketPath_.c_str());
+    }
+
+    SimulationService(const SimulationService&) = delete;
+    SimulationService& operator=(const SimulationService&) = delete;
+
+    // Accepts and dispatches connections until Stop is called.
+    void Serve() {
+        while (!stopping_) {
+            pollfd listener{listener_, POLLIN, 0};
+            int ready = poll(&listener, 1, 100); // Wakes up regularly to notice Stop
+            if (ready <= 0) {
+                if (ready < 0 && errno != EINTR) {
+                    throw std::system_error(errno, std::generic_category(), "Cannot wait for connections");
+                }
+                continue;
+            }
+            int socket = accept4(listener_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (socket < 0) {
+                continue; // E.g. the client gave up already
+            }
+
+            auto connection = std::make_shared<ServiceConnection>(socket);
+            connection->SetTimeout(settings_.timeoutSeconds);
+            if (admittedRuns_ >= settings_.threads + settings_.maxQueuedRuns) {
+                TrySendError(*connection, "Service busy, try again later");
+                continue;
+            }
+            admittedRuns_++;
+            scheduler_.Submit(runs_, [this, connection] {
+                HandleConnection(*connection);
+                admittedRuns_--;
+            });
+        }
+    }
+
+    // Makes Serve return and running requests end with an Error frame. Only sets a flag, so it may be called from a signal handler.
+    void Stop() {
+        stopping_ = true;
+    }
+
+    const std::string& GetSocketPath() const {
+        return socketPath_;
+    }
+
+private:
+    void HandleConnection(ServiceConnection& connection) {
+        try {
+            ServiceFrame type;
+            std::vector<uint8_t> payload;
+            if (!connection.Receive(type, payload, settings_.maxRequestSize)) {
+                return; // Closed without a request
+            }
+            if (type != ServiceFrame::Request) {
+                throw std::runtime_error("Expected a request frame");
+            }
+
+            std::istringstream text(std::string(payload.begin(), payload.end()));
+            auto scenarios = ScenarioFile::Parse(text, "request", "request");
+            if (scenarios.size() != 1) {
+                throw std::runtime_error("A request must describe a single scenario, not a sweep of " + std::to_string(scenarios.size()));
+            }
+            Stream(connection, scenarios.front());
+        } catch (const std::exception& e) {
+            TrySendError(connection, e.what());
+        }
+    }
+
+    // Runs the scenario and sends its frames. Throws if the client is gone, which ends the run.
+    void Stream(ServiceConnection& connection, const Scenario& scenario) {
+        ScenarioRun run(scenario, worldCache_, &scheduler_);
+        World& world = run.GetWorld();
+        auto isBurningParam = world.GetVectorParameter<bool>("isBurning");
+        auto hasBurnedParam = world.GetVectorParameter<bool>("hasBurned");
+
+        BinaryWriter started;
+        started.WriteVarUInt(static_cast<uint64_t>(world.GetWidth()));
+        started.WriteVarUInt(static_cast<uint64_t>(world.GetDepth()));
+        started.Write<uint8_t>(run.IsWorldFromCache());
+        connection.Send(ServiceFrame::Started, started.GetBuffer());
+
+        ServiceStep step;
+        auto sendChanges = [&](const std::vector<Tile*>& tiles) {
+            step.step = run.GetSteps();
+            step.changes.clear();
+            for (auto* tile : tiles) {
+                uint32_t tileIndex = static_cast<uint32_t>(world.GetTileIndex(tile));
+                TileState state = isBurningParam->GetValue(tileIndex) ? TileState::Burning
+                                : hasBurnedParam->GetValue(tileIndex) ? TileState::Burned : TileState::Unburned;
+                step.changes.emplace_back(tileIndex, state);
+            }
+            std::sort(step.changes.begin(), step.changes.end());
+            step.changes.erase(std::unique(step.changes.begin(), step.changes.end(),
+                                           [](const auto& a, const auto& b) { return a.first == b.first; }),
+                               step.changes.end());
+            connection.Send(ServiceFrame::Step, step.Encode());
+        };
+
+        sendChanges(run.GetStartingTiles());
+        while (!run.HasEnded()) {
+            if (stopping_) {
+                throw std::runtime_error("Service stopping");
+            }
+            run.Step();
+            sendChanges(run.GetSimulation().GetLastChangedTiles());
+        }
+
+        std::size_t burned = 0;
+        std::size_t burning = 0;
+        for (std::size_t i = 0; i < isBurningParam->Size(); ++i) {
+            burning += isBurningParam->GetValue(i);
+            burned += hasBurnedParam->GetValue(i);
+        }
+        BinaryWriter finished;
+        finished.WriteVarUInt(static_cast<uint64_t>(run.GetSteps()));
+        finished.WriteVarUInt(burned);
+        finished.WriteVarUInt(burning);
+        finished.Write<uint8_t>(run.GetSimulation().HasEnded());
+        connection.Send(ServiceFrame::Finished, finished.GetBuffer());
+    }
+
+    static void TrySendError(ServiceConnection& connection, const std::string& message) {
+        try {
+            connection.Send(ServiceFrame::Error, message);
+        } catch (const std::exception&) {
+            // The client is gone, nobody to tell
+        }
+    }
+};
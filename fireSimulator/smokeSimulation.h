@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+#include "simulation.h"
+#include "taskScheduler.h"
+
+// Settings of the smoke dispersion.
+struct SmokeSettings {
+    float emissionRate = 0.05f; // Smoke a burning forest tile emits per step, other vegetation emits less
+    float windScale = 0.2f;     // Tiles the smoke drifts per step and unit of wind speed
+    float diffusion = 0.1f;     // Share of a cell's smoke exchanged with each neighbor per step and axis, at most 0.5
+    float decay = 0.01f;        // Share of the smoke that settles or thins out per step
+};
+
+// Smoke dispersion coupled to a fire simulation. Every step the tiles burning in the fire emit smoke into a grid that is cellSize times
+// coarser than the world, which is then carried by the wind (semi-Lagrangian advection with bilinear interpolation) and spread by a
+// separable 3-tap diffusion kernel.
+//
+// The wind is the same everywhere, so the interpolation weights and offsets are the same for all cells and every pass is a plain loop over
+// contiguous rows that the compiler vectorizes. The planes are padded by the farthest distance smoke can drift in one step, so no pass needs
+// bounds checks, and smoke leaving the grid is dropped. With a scheduler the rows are split into bands updated in parallel.
+//
+// The smoke does not change the world or the fire, it only exposes its concentration, e.g. for the visualizer overlay.
+class SmokeSimulation : public Simulation {
+    static constexpr float MaxWindSpeed = 50.0f;
+    static constexpr float MinConcentration = 1e-3f; // Smoke below this no longer counts when checking whether the run ended
+
+    World& world_;
+    const FireSpreadSimulation& fire_;
+    SmokeSettings settings_;
+    int cellSize_;
+    TaskScheduler* scheduler_;
+
+    int gridWidth_;
+    int gridDepth_;
+    int padding_;
+    std::size_t stride_; // Floats per padded row
+    std::vector<float> concentration_;
+    std::vector<float> scratch_;
+    float maxConcentration_ = 0;
+
+public:
+    // cellSize is the number of world tiles along each side of a smoke cell. The fire simulation must outlive the smoke simulation.
+    SmokeSimulation(World& world, const FireSpreadSimulation& fire, int cellSize = 4, TaskScheduler* scheduler = nullptr, SmokeSettings settings = {})
+            : world_(world), fire_(fire), settings_(settings), cellSize_(cellSize), scheduler_(scheduler) {
+        if (cellSize_ < 1) {
+            throw std::invalid_argument("Smoke cell size must be at least 1");
+        }
+        if (settings_.diffusion < 0 || settings_.diffusion > 0.5f || settings_.decay < 0 || settings_.decay > 1) {
+            throw std::invalid_argument("Smoke diffusion must be in [0, 0.5] and decay in [0, 1]");
+        }
+        gridWidth_ = (world_.GetWidth() + cellSize_ - 1) / cellSize_;
+        gridDepth_ = (world_.GetDepth() + cellSize_ - 1) / cellSize_;
+        padding_ = static_cast<int>(std::ceil(MaxWindSpeed * settings_.windScale / cellSize_)) + 1;
+        stride_ = static_cast<std::size_t>(gridDepth_ + 2 * padding_);
+        concentration_.assign(stride_ * (gridWidth_ + 2 * padding_), 0.0f);
+        scratch_.assign(concentration_.size(), 0.0f);
+    }
+
+    //  Clears the smoke; the fire simulation is initialized separately.
+    void Initialize(std::vector<Tile*>&) override {
+        Reset();
+    }
+
+    //  Emits smoke from the tiles currently burning in the fire, then advects and diffuses it.
+    void Update() override {
+        Emit();
+        Advect();
+        Diffuse();
+    }
+
+    //  The smoke has ended once the fire is out and the remaining smoke has thinned out.
+    bool HasEnded() const override {
+        return fire_.HasEnded() && maxConcentration_ < MinConcentration;
+    }
+
+    //  Removes all smoke.
+    void Reset() override {
+        std::fill(concentration_.begin(), concentration_.end(), 0.0f);
+        maxConcentration_ = 0;
+    }
+
+    //  The smoke does not change any tiles.
+    const std::vector<Tile*>& GetLastChangedTiles() const override {
+        static const std::vector<Tile*> none;
+        return none;
+    }
+
+    std::vector<Tile*> GetProhibitedTiles() const override {
+        return {};
+    }
+
+    std::unordered_map<int, sf::Color> GetChangedTileColors() const override {
+        return {};
+    }
+
+    //  Smoke concentration of the cell at the given cell coordinates.
+    float GetConcentration(int cellX, int cellY) const {
+        return concentration_[Index(cellX, cellY)];
+    }
+
+    //  Smoke concentration of all cells, row by row (cellX * gridDepth + cellY).
+    std::vector<float> GetConcentrations() const {
+        std::vector<float> values(static_cast<std::size_t>(gridWidth_) * gridDepth_);
+        for (int cellX = 0; cellX < gridWidth_; ++cellX) {
+            std::copy_n(&concentration_[Index(cellX, 0)], gridDepth_, &values[static_cast<std::size_t>(cellX) * gridDepth_]);
+        }
+        return values;
+    }
+
+    float GetMaxConcentration() const {
+        return maxConcentration_;
+    }
+
+    int GetCellSize() const {
+        return cellSize_;
+    }
+
+    int GetGridWidth() const {
+        return gridWidth_;
+    }
+
+    int GetGridDepth() const {
+        return gridDepth_;
+    }
+
+private:
+    std::size_t Index(int cellX, int cellY) const {
+        return static_cast<std::size_t>(cellX + padding_) * stride_ + static_cast<std::size_t>(cellY + padding_);
+    }
+
+    //  Adds the smoke of the burning tiles to their cells. Forests (longest burn time) emit the full rate.
+    void Emit() {
+        for (auto* tile : fire_.GetBurningTiles()) {
+            float emission = settings_.emissionRate * FireSpreadSimulation::GetBurnTime(tile->GetVegetation()) / 4.0f;
+            concentration_[Index(tile->GetWidthPosition() / cellSize_, tile->GetDepthPosition() / cellSize_)] += emission;
+        }
+    }
+
+    //  Moves the smoke with the wind by tracing every cell back along the wind and interpolating the smoke found there.
+    void Advect() {
+        float windSpeed = world_.GetParameter<float>("windSpeed")->GetValue();
+        int windDirection = world_.GetParameter<int>("windDirection")->GetValue();
+        // Same convention as the fire: the wind blows towards its direction, measured from the x axis towards the y axis
+        float radians = windDirection * static_cast<float>(M_PI / 180);
+        float distance = windSpeed * settings_.windScale / cellSize_;
+        float sourceX = -distance * std::cos(radians);
+        float sourceY = -distance * std::sin(radians);
+
+        int offsetX = static_cast<int>(std::floor(sourceX));
+        int offsetY = static_cast<int>(std::floor(sourceY));
+        float fractionX = sourceX - offsetX;
+        float fractionY = sourceY - offsetY;
+        float weight00 = (1 - fractionX) * (1 - fractionY);
+        float weight01 = (1 - fractionX) * fractionY;
+        float weight10 = fractionX * (1 - fractionY);
+        float weight11 = fractionX * fractionY;
+
+        ForEachRowBand([&](int fromX, int toX) {
+            for (int cellX = fromX; cellX < toX; ++cellX) {
+                const float* row0 = &concentration_[Index(cellX + offsetX, offsetY)];
+                const float* row1 = row0 + stride_;
+                float* out = &scratch_[Index(cellX, 0)];
+                for (int cellY = 0; cellY < gridDepth_; ++cellY) {
+                    out[cellY] = weight00 * row0[cellY] + weight01 * row0[cellY + 1] + weight10 * row1[cellY] + weight11 * row1[cellY + 1];
+                }
+            }
+        });
+        concentration_.swap(scratch_);
+    }
+
+    //  Spreads the smoke along the depth axis, then along the width axis, and lets a share of it decay.
+    void Diffuse() {
+        const float side = settings_.diffusion;
+        const float center = 1 - 2 * side;
+        const float keep = 1 - settings_.decay;
+
+        ForEachRowBand([&](int fromX, int toX) {
+            for (int cellX = fromX; cellX < toX; ++cellX) {
+                const float* in = &concentration_[Index(cellX, 0)];
+                float* out = &scratch_[Index(cellX, 0)];
+                for (int cellY = 0; cellY < gridDepth_; ++cellY) {
+                    out[cellY] = side * in[cellY - 1] + center * in[cellY] + side * in[cellY + 1];
+                }
+            }
+        });
+
+        std::vector<float> rowMax(gridWidth_, 0.0f);
+        ForEachRowBand([&](int fromX, int toX) {
+            for (int cellX = fromX; cellX < toX; ++cellX) {
+                const float* in = &scratch_[Index(cellX, 0)];
+                float* out = &concentration_[Index(cellX, 0)];
+                float localMax = 0;
+                for (int cellY = 0; cellY < gridDepth_; ++cellY) {
+                    out[cellY] = keep * (side * in[cellY - stride_] + center * in[cellY] + side * in[cellY + stride_]);
+                    localMax = std::max(localMax, out[cellY]);
+                }
+                rowMax[cellX] = localMax;
+            }
+        });
+        maxConcentration_ = *std::max_element(rowMax.begin(), rowMax.end());
+    }
+
+    //  Calls band(fromX, toX) for bands of rows covering the grid, in parallel when there is a scheduler.
+    template <typename BandFunction>
+    void ForEachRowBand(BandFunction&& band) {
+        if (scheduler_ == nullptr) {
+            band(0, gridWidth_);
+            return;
+        }
+        scheduler_->ParallelFor(0, gridWidth_, 0, [&band](std::size_t fromX, std::size_t toX) {
+            band(static_cast<int>(fromX), static_cast<int>(toX));
+        });
+    }
+};
@@ -0,0 +1,179 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "perlin.h"
+
+// Samples from a discrete distribution in constant time (Vose's alias method). Building the table is linear in the number of outcomes.
+class AliasTable {
+    std::vector<float> probabilities_;
+    std::vector<uint32_t> aliases_;
+
+public:
+    explicit AliasTable(const std::vector<float>& weights) : probabilities_(weights.size()), aliases_(weights.size()) {
+        if (weights.empty()) {
+            throw std::invalid_argument("Alias table needs at least one outcome");
+        }
+        double total = 0;
+        for (float weight : weights) {
+            total += weight;
+        }
+        if (total <= 0) {
+            throw std::invalid_argument("Alias table weights must not all be zero");
+        }
+
+        std::size_t count = weights.size();
+        std::vector<double> scaled(count);
+        std::vector<uint32_t> small;
+        std::vector<uint32_t> large;
+        for (std::size_t i = 0; i < count; ++i) {
+            scaled[i] = weights[i] * count / total;
+            (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+        }
+        while (!small.empty() && !large.empty()) {
+            uint32_t less = small.back();
+            small.pop_back();
+            uint32_t more = large.back();
+            probabilities_[less] = static_cast<float>(scaled[less]);
+            aliases_[less] = more;
+            scaled[more] -= 1.0 - scaled[less];
+            if (scaled[more] < 1.0) {
+                large.pop_back();
+                small.push_back(more);
+            }
+        }
+        // Leftovers are 1 up to rounding errors
+        for (auto i : large) {
+            probabilities_[i] = 1.0f;
+            aliases_[i] = i;
+        }
+        for (auto i : small) {
+            probabilities_[i] = 1.0f;
+            aliases_[i] = i;
+        }
+    }
+
+    // Outcome for a uniform draw in [0, 1). One draw picks both the column and the side of it.
+    uint32_t Sample(float uniform) const {
+        float scaled = uniform * static_cast<float>(probabilities_.size());
+        auto column = std::min(static_cast<std::size_t>(scaled), probabilities_.size() - 1);
+        return scaled - static_cast<float>(column) < probabilities_[column] ? static_cast<uint32_t>(column) : aliases_[column];
+    }
+
+    std::size_t Size() const {
+        return probabilities_.size();
+    }
+};
+
+// Settings of ember spotting.
+struct SpottingSettings {
+    int maxDistance = 20;    // Farthest landing point in tiles
+    float emberRate = 0.05f; // Expected embers per burning forest tile and step without wind
+    float ignitionFactor = 0.5f; // Scales the chance an ember ignites the tile it lands on
+};
+
+// Long-range fire spread by embers carried with the wind. Every burning tile throws a random number of embers per step, each landing at a
+// distance and angle drawn from wind-skewed distributions: stronger wind throws more embers, farther and more tightly downwind.
+// The distributions are alias tables built once per integer wind speed, so casting an ember is O(1) regardless of the spotting distance.
+class EmberSpotting {
+    static constexpr int MaxEmbers = 8; // Per tile and step
+    static constexpr int AngleBins = 32;
+    static constexpr int MaxWindSpeed = 50;
+
+    struct Distributions {
+        AliasTable distance; // Outcome i lands at i + 2 tiles, adjacent tiles are covered by normal spread
+        AliasTable angle;    // Outcome i is the i-th angle bin around the wind direction
+    };
+
+    SpottingSettings settings_;
+    std::array<std::unique_ptr<Distributions>, MaxWindSpeed + 1> distributions_;
+
+public:
+    explicit EmberSpotting(SpottingSettings settings = {}) : settings_(settings) {
+        if (settings_.maxDistance < 2) {
+            throw std::invalid_argument("Spotting distance must be at least 2 tiles");
+        }
+    }
+
+    const SpottingSettings& GetSettings() const {
+        return settings_;
+    }
+
+    // Casts the embers of one burning tile and calls land(deltaX, deltaY, uniform) for every landing point, with a fresh uniform draw
+    // to decide the ignition. All draws are keyed by the source tile, so the result does not depend on the order of the sources.
+    // fuelFactor scales the number of embers by how much the source vegetation produces.
+    template <typename LandFunction>
+    void CastEmbers(const CounterRandom& random, uint32_t sourceIndex, float fuelFactor, float windSpeed, int windDirection, LandFunction&& land) {
+        float expectedEmbers = settings_.emberRate * fuelFactor * (1.0f + windSpeed * 0.1f);
+        int emberCount = SamplePoisson(expectedEmbers, random.Uniform(sourceIndex, 0));
+        if (emberCount == 0) {
+            return;
+        }
+
+        const Distributions& distributions = GetDistributions(windSpeed);
+        const float binWidth = 360.0f / AngleBins;
+        for (int ember = 0; ember < emberCount; ++ember) {
+            uint32_t subStream = 1 + static_cast<uint32_t>(ember) * 4;
+            float distance = static_cast<float>(distributions.distance.Sample(random.Uniform(sourceIndex, subStream)) + 2);
+            float bin = static_cast<float>(distributions.angle.Sample(random.Uniform(sourceIndex, subStream + 1)));
+            float angle = windDirection + (bin - AngleBins / 2 + random.Uniform(sourceIndex, subStream + 2)) * binWidth;
+
+            // Same convention as GetWindFactor: the angle is measured from the x axis towards the y axis
+            float radians = angle * static_cast<float>(M_PI / 180);
+            int deltaX = static_cast<int>(std::lround(distance * std::cos(radians)));
+            int deltaY = static_cast<int>(std::lround(distance * std::sin(radians)));
+            land(deltaX, deltaY, random.Uniform(sourceIndex, subStream + 3));
+        }
+    }
+
+private:
+    // Distributions for the wind speed, rounded down to whole speeds and built on first use.
+    const Distributions& GetDistributions(float windSpeed) {
+        int speed = std::clamp(static_cast<int>(windSpeed), 0, MaxWindSpeed);
+        if (!distributions_[speed]) {
+            distributions_[speed] = std::make_unique<Distributions>(Distributions{BuildDistanceTable(speed), BuildAngleTable(speed)});
+        }
+        return *distributions_[speed];
+    }
+
+    // Log-normal landing distances, the typical distance growing with the wind speed.
+    AliasTable BuildDistanceTable(int windSpeed) const {
+        float median = std::min(2.0f + windSpeed * 0.3f, static_cast<float>(settings_.maxDistance));
+        float sigma = 0.5f;
+        std::vector<float> weights;
+        for (int distance = 2; distance <= settings_.maxDistance; ++distance) {
+            float z = (std::log(static_cast<float>(distance)) - std::log(median)) / sigma;
+            weights.push_back(std::exp(-0.5f * z * z) / distance);
+        }
+        return AliasTable(weights);
+    }
+
+    // Angles around the wind direction (von Mises), uniform without wind and tightly downwind in strong wind.
+    static AliasTable BuildAngleTable(int windSpeed) {
+        float concentration = windSpeed * 0.2f;
+        std::vector<float> weights;
+        for (int bin = 0; bin < AngleBins; ++bin) {
+            float angle = (bin - AngleBins / 2 + 0.5f) * static_cast<float>(2 * M_PI / AngleBins);
+            weights.push_back(std::exp(concentration * (std::cos(angle) - 1.0f)));
+        }
+        return AliasTable(weights);
+    }
+
+    // Poisson-distributed count by inversion, capped at MaxEmbers.
+    static int SamplePoisson(float mean, float uniform) {
+        float probability = std::exp(-mean);
+        float cumulative = probability;
+        int count = 0;
+        while (uniform >= cumulative && count < MaxEmbers) {
+            count++;
+            probability *= mean / count;
+            cumulative += probability;
+        }
+        return count;
+    }
+};
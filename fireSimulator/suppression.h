@@ -0,0 +1,130 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Kinds of firefighting actions.
+enum class SuppressionType {
+    Firebreak, // Removes all fuel, the tiles can no longer burn
+    Retardant, // Scales the fuel of the tiles by (1 - strength)
+    Water      // Adds strength moisture points and puts out tiles burning in the area
+};
+
+// Timed edit of an area of the world, applied at the start of its step. The area is either a polygon or a brush stroke, i.e. all tiles
+// within the brush radius of a path. Coordinates are tile positions (x = width position, y = depth position).
+struct SuppressionAction {
+    int step = 0;
+    SuppressionType type = SuppressionType::Firebreak;
+    float strength = 1.0f;
+    std::vector<std::pair<float, float>> points; // Polygon vertices or brush path
+    float brushRadius = -1.0f; // Negative for polygons
+
+    static SuppressionAction Polygon(int step, SuppressionType type, float strength, std::vector<std::pair<float, float>> vertices) {
+        if (vertices.size() < 3) {
+            throw std::invalid_argument("Suppression polygon needs at least 3 vertices");
+        }
+        return {step, type, strength, std::move(vertices), -1.0f};
+    }
+
+    static SuppressionAction Brush(int step, SuppressionType type, float strength, std::vector<std::pair<float, float>> path, float radius) {
+        if (path.empty() || radius < 0) {
+            throw std::invalid_argument("Suppression brush needs a path and a radius of at least 0");
+        }
+        return {step, type, strength, std::move(path), radius};
+    }
+
+    bool IsBrush() const {
+        return brushRadius >= 0;
+    }
+
+    // Indices (x * depth + y) of the tiles in the area, sorted and without duplicates. Only the bounding box of the area is visited.
+    std::vector<uint32_t> GetTiles(int width, int depth) const {
+        std::vector<uint32_t> tiles;
+        if (IsBrush()) {
+            for (std::size_t i = 0; i < points.size(); ++i) {
+                AddStrokeTiles(points[i], points[std::min(i + 1, points.size() - 1)], width, depth, tiles);
+            }
+            std::sort(tiles.begin(), tiles.end());
+            tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+        } else {
+            AddPolygonTiles(width, depth, tiles);
+        }
+        return tiles;
+    }
+
+private:
+    void AddStrokeTiles(std::pair<float, float> from, std::pair<float, float> to, int width, int depth, std::vector<uint32_t>& tiles) const {
+        int minX = std::max(0, static_cast<int>(std::ceil(std::min(from.first, to.first) - brushRadius)));
+        int maxX = std::min(width - 1, static_cast<int>(std::floor(std::max(from.first, to.first) + brushRadius)));
+        int minY = std::max(0, static_cast<int>(std::ceil(std::min(from.second, to.second) - brushRadius)));
+        int maxY = std::min(depth - 1, static_cast<int>(std::floor(std::max(from.second, to.second) + brushRadius)));
+
+        float segmentX = to.first - from.first;
+        float segmentY = to.second - from.second;
+        float lengthSquared = segmentX * segmentX + segmentY * segmentY;
+        for (int x = minX; x <= maxX; ++x) {
+            for (int y = minY; y <= maxY; ++y) {
+                // Distance of the tile to the closest point of the segment
+                float t = lengthSquared > 0 ? std::clamp(((x - from.first) * segmentX + (y - from.second) * segmentY) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+                float distanceX = x - (from.first + t * segmentX);
+                float distanceY = y - (from.second + t * segmentY);
+                if (distanceX * distanceX + distanceY * distanceY <= brushRadius * brushRadius) {
+                    tiles.push_back(static_cast<uint32_t>(x * depth + y));
+                }
+            }
+        }
+    }
+
+    // Scanline fill with the even-odd rule, one row of tiles per width position.
+    void AddPolygonTiles(int width, int depth, std::vector<uint32_t>& tiles) const {
+        float minX = points[0].first;
+        float maxX = points[0].first;
+        for (const auto& point : points) {
+            minX = std::min(minX, point.first);
+            maxX = std::max(maxX, point.first);
+        }
+
+        std::vector<float> crossings;
+        for (int x = std::max(0, static_cast<int>(std::ceil(minX))); x <= std::min(width - 1, static_cast<int>(std::floor(maxX))); ++x) {
+            crossings.clear();
+            for (std::size_t i = 0; i < points.size(); ++i) {
+                const auto& a = points[i];
+                const auto& b = points[(i + 1) % points.size()];
+                if ((a.first <= x && b.first > x) || (b.first <= x && a.first > x)) {
+                    crossings.push_back(a.second + (x - a.first) / (b.first - a.first) * (b.second - a.second));
+                }
+            }
+            std::sort(crossings.begin(), crossings.end());
+            for (std::size_t i = 0; i + 1 < crossings.size(); i += 2) {
+                int fromY = std::max(0, static_cast<int>(std::ceil(crossings[i])));
+                int toY = std::min(depth - 1, static_cast<int>(std::floor(crossings[i + 1])));
+                for (int y = fromY; y <= toY; ++y) {
+                    tiles.push_back(static_cast<uint32_t>(x * depth + y));
+                }
+            }
+        }
+    }
+};
+
+// Firefighting plan: suppression actions ordered by their step.
+class SuppressionPlan {
+    std::vector<SuppressionAction> actions_;
+
+public:
+    void AddAction(SuppressionAction action) {
+        auto it = std::upper_bound(actions_.begin(), actions_.end(), action.step,
+                                   [](int step, const SuppressionAction& existing) { return step < existing.step; });
+        actions_.insert(it, std::move(action));
+    }
+
+    bool IsEmpty() const {
+        return actions_.empty();
+    }
+
+    const std::vector<SuppressionAction>& GetActions() const {
+        return actions_;
+    }
+};
@@ -0,0 +1,259 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Priority of a task. Threads waiting for a group only help with High tasks and the tasks of that group, so High is meant for short,
+// non-blocking loop bodies (ParallelFor uses it) that a waiting thread can always run without deadlocking.
+enum class TaskPriority {
+    High = 0,  // Fork/join loop bodies, finishing them unblocks the task waiting for them
+    Normal = 1, // Independent jobs, e.g. the runs of an ensemble
+    Low = 2    // Background work such as writing outputs
+};
+
+// Fork/join region: counts the unfinished tasks submitted with it and keeps the first exception one of them threw.
+class TaskGroup {
+    friend class TaskScheduler;
+
+    std::atomic<std::size_t> pending_{0};
+    std::mutex errorMutex_;
+    std::exception_ptr error_;
+
+public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+};
+
+// Work-stealing scheduler shared by world generation, simulations, ensembles and exports, so the whole process never runs more threads
+// than the scheduler has workers (plus threads blocked waiting for their own tasks, which help instead of idling).
+//
+// Every worker owns a deque per priority. Tasks submitted by a worker go to the back of its own deque and it takes work from the back too
+// (the most recently split, cache-warm part), while idle workers steal from the front of the others' deques (the largest, oldest parts).
+// Tasks submitted from other threads go to a shared injection queue. Higher priorities are always taken first.
+class TaskScheduler {
+    static constexpr int PriorityCount = 3;
+
+    struct Task {
+        std::function<void()> function;
+        TaskGroup* group;
+        TaskPriority priority;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks[PriorityCount];
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_; // One per worker, the last one is the injection queue
+    std::vector<std::thread> workers_;
+    std::atomic<long> queuedTasks_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+
+    inline static thread_local TaskScheduler* currentScheduler_ = nullptr;
+    inline static thread_local std::size_t currentWorker_ = 0;
+
+public:
+    explicit TaskScheduler(std::size_t threadCount = std::thread::hardware_concurrency()) {
+        threadCount = std::max<std::size_t>(1, threadCount);
+        for (std::size_t i = 0; i <= threadCount; ++i) {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+        for (std::size_t i = 0; i < threadCount; ++i) {
+            workers_.emplace_back([this, i] { WorkerLoop(i); });
+        }
+    }
+
+    // Finishes the queued tasks, then stops the workers.
+    ~TaskScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Process-wide scheduler with one worker per hardware thread, for code that is not handed a scheduler explicitly.
+    static TaskScheduler& Shared() {
+        static TaskScheduler scheduler;
+        return scheduler;
+    }
+
+    std::size_t GetThreadCount() const {
+        return workers_.size();
+    }
+
+    // Queues a task of the group. The group must outlive the task, i.e. be waited for before it goes out of scope.
+    void Submit(TaskGroup& group, std::function<void()> task, TaskPriority priority = TaskPriority::Normal) {
+        group.pending_++;
+        queuedTasks_++;
+        Queue& queue = currentScheduler_ == this ? *queues_[currentWorker_] : *queues_.back();
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks[static_cast<int>(priority)].push_back({std::move(task), &group, priority});
+        }
+        { std::lock_guard<std::mutex> lock(sleepMutex_); } // A thread about to sleep has either seen the task or is waiting already
+        if (priority == TaskPriority::High) {
+            wake_.notify_one(); // Any woken thread may run it
+        } else {
+            wake_.notify_all(); // A single wakeup could go to a thread in Wait that must not run it and would swallow the wakeup
+        }
+    }
+
+    // Blocks until all tasks of the group have finished, running tasks of the group (and High tasks) meanwhile. Rethrows the first exception
+    // a task of the group threw.
+    void Wait(TaskGroup& group) {
+        while (group.pending_ > 0) {
+            Task task;
+            if (TryTakeTask(&group, task)) {
+                Execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            wake_.wait(lock, [this, &group] { return group.pending_ == 0 || queuedTasks_ > 0; });
+            if (group.pending_ > 0 && queuedTasks_ > 0) {
+                // The queued tasks may all be ones this thread must not run, so do not spin on them
+                wake_.wait_for(lock, std::chrono::microseconds(100), [&group] { return group.pending_ == 0; });
+            }
+        }
+        std::lock_guard<std::mutex> lock(group.errorMutex_);
+        if (group.error_) {
+            std::exception_ptr error = group.error_;
+            group.error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Calls body(from, to) on subranges of [begin, end) no larger than grainSize (0 picks one giving each worker several parts) and returns
+    // when all have finished. The range is split in halves recursively, so idle workers steal large parts and the caller keeps the rest.
+    template <typename Body>
+    void ParallelFor(std::size_t begin, std::size_t end, std::size_t grainSize, Body&& body) {
+        if (begin >= end) {
+            return;
+        }
+        if (grainSize == 0) {
+            grainSize = std::max<std::size_t>(1, (end - begin) / (GetThreadCount() * 8));
+        }
+
+        TaskGroup group;
+        std::function<void(std::size_t, std::size_t)> split = [&](std::size_t from, std::size_t to) {
+            while (to - from > grainSize) {
+                std::size_t middle = from + (to - from) / 2;
+                Submit(group, [&split, middle, to] { split(middle, to); }, TaskPriority::High);
+                to = middle;
+            }
+            body(from, to);
+        };
+
+        std::exception_ptr error;
+        try {
+            split(begin, end);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        try {
+            Wait(group); // The subranges reference this frame, so wait even if this thread's part failed
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    void WorkerLoop(std::size_t index) {
+        currentScheduler_ = this;
+        currentWorker_ = index;
+        while (true) {
+            Task task;
+            if (TryTakeTask(nullptr, task)) {
+                Execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            wake_.wait(lock, [this] { return stopping_ || queuedTasks_ > 0; });
+            if (stopping_ && queuedTasks_ == 0) {
+                return;
+            }
+        }
+    }
+
+    // Takes the next task by priority: from the back of this worker's own deque, then the injection queue, then the front of the other
+    // workers' deques. A waiting thread (waitingFor set) only takes High tasks and tasks of the group it waits for.
+    bool TryTakeTask(TaskGroup* waitingFor, Task& task) {
+        std::size_t own = currentScheduler_ == this ? currentWorker_ : queues_.size() - 1;
+        for (int priority = 0; priority < PriorityCount; ++priority) {
+            if (TryTakeFrom(*queues_[own], priority, own != queues_.size() - 1, waitingFor, task)) {
+                return true;
+            }
+            for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+                std::size_t victim = (own + offset) % queues_.size();
+                if (TryTakeFrom(*queues_[victim], priority, false, waitingFor, task)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool TryTakeFrom(Queue& queue, int priority, bool fromBack, TaskGroup* waitingFor, Task& task) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        auto& tasks = queue.tasks[priority];
+        if (tasks.empty()) {
+            return false;
+        }
+        auto allowed = [waitingFor](const Task& candidate) {
+            return waitingFor == nullptr || candidate.priority == TaskPriority::High || candidate.group == waitingFor;
+        };
+        if (fromBack) {
+            auto it = std::find_if(tasks.rbegin(), tasks.rend(), allowed);
+            if (it == tasks.rend()) {
+                return false;
+            }
+            task = std::move(*it);
+            tasks.erase(std::next(it).base());
+        } else {
+            auto it = std::find_if(tasks.begin(), tasks.end(), allowed);
+            if (it == tasks.end()) {
+                return false;
+            }
+            task = std::move(*it);
+            tasks.erase(it);
+        }
+        queuedTasks_--;
+        return true;
+    }
+
+    void Execute(Task& task) {
+        try {
+            task.function();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(task.group->errorMutex_);
+            if (!task.group->error_) {
+                task.group->error_ = std::current_exception();
+            }
+        }
+        if (--task.group->pending_ == 0) {
+            { std::lock_guard<std::mutex> lock(sleepMutex_); }
+            wake_.notify_all();
+        }
+    }
+};
@@ -1,6 +1,7 @@
 #include <utility>
 
 #pragma once
+#include "simulation.h"
 
 class Visualizer {
     int windowWidth;
@@ -15,6 +16,7 @@ class Visualizer {
 
     std::pair<int, int> lastHighlightedTileCoords = {-1, -1}; // Stores the last highlighted tile's row and column
     std::unordered_map<int, sf::Color> simulationTileColors; // For custom requested tile colors by simulation
+    std::vector<sf::RectangleShape> overlayCells; // Translucent cells drawn over the tiles, e.g. smoke
 
     const int MARGIN_FOR_TILES = 1; // Number of pixels between tiles
 
@@ -41,6 +43,7 @@ public:
     void Reset() {
         lastHighlightedTileCoords = {-1, -1}; // Stores the last highlighted tile's row and column
         simulationTileColors.clear();
+        overlayCells.clear();
         resetPermanentlyHighlightedTiles();
         initializeTiles();
 
@@ -65,6 +68,10 @@ public:
     void highlightTile(int row, int col);
     void permanentlyHighlightTile(int row, int col);
     void updateTileColors(const std::unordered_map<int, sf::Color>& updatedColors);
+    void updateTileStates(const std::vector<uint32_t>& tileIndices, const std::vector<TileState>& states);
+    void restoreTileColors(const std::vector<int>& tileIndices);
+    void setOverlay(const std::vector<float>& values, int gridWidth, int gridDepth, int cellSize, float fullValue, sf::Color color);
+    void clearOverlay();
 
     void redrawElements();
 };
@@ -235,6 +242,61 @@ void Visualizer::updateTileColors(const std::unordered_map<int, sf::Color>& upda
     initializeTiles();
 }
 
+// Colors tiles by their fire state, e.g. from the changes a simulation publishes to its observers. Unburned tiles show the terrain again.
+void Visualizer::updateTileStates(const std::vector<uint32_t>& tileIndices, const std::vector<TileState>& states) {
+    for (std::size_t i = 0; i < tileIndices.size(); ++i) {
+        if (states[i] == TileState::Unburned) {
+            simulationTileColors.erase(static_cast<int>(tileIndices[i]));
+        } else {
+            simulationTileColors[static_cast<int>(tileIndices[i])] = FireSpreadSimulation::GetTileStateColor(states[i]);
+        }
+    }
+    initializeTiles();
+}
+
+// Removes simulation colors of the given tiles so they show the terrain again, e.g. when a replay goes back in time
+void Visualizer::restoreTileColors(const std::vector<int>& tileIndices) {
+    if (tileIndices.empty()) {
+        return;
+    }
+    for (int tileIndex : tileIndices) {
+        simulationTileColors.erase(tileIndex);
+    }
+    initializeTiles();
+}
+
+// Sets a translucent overlay of cells, each covering cellSize x cellSize tiles. values holds one value per cell (cellX * gridDepth + cellY),
+// the cell opacity grows with its value up to the opacity of color at fullValue. Cells with nothing to show are not drawn.
+void Visualizer::setOverlay(const std::vector<float>& values, int gridWidth, int gridDepth, int cellSize, float fullValue, sf::Color color) {
+    int allBordersSize = (world->TilesOnSide() - 1) * MARGIN_FOR_TILES;
+    int tileSize = (windowHeight - allBordersSize) / world->TilesOnSide();
+    float cellPixels = static_cast<float>(cellSize * (tileSize + MARGIN_FOR_TILES));
+    float maxAlpha = color.a;
+
+    overlayCells.clear();
+    for (int cellX = 0; cellX < gridWidth; ++cellX) {
+        for (int cellY = 0; cellY < gridDepth; ++cellY) {
+            float opacity = std::min(1.0f, values[cellX * gridDepth + cellY] / fullValue);
+            if (opacity * maxAlpha < 1.0f) {
+                continue;
+            }
+            // Same layout as the tiles: rows are width positions, columns depth positions
+            int visibleTiles = std::min(cellSize, world->TilesOnSide() - cellY * cellSize);
+            int visibleRows = std::min(cellSize, world->TilesOnSide() - cellX * cellSize);
+            sf::RectangleShape cell(sf::Vector2f(visibleTiles * (tileSize + MARGIN_FOR_TILES) - MARGIN_FOR_TILES,
+                                                 visibleRows * (tileSize + MARGIN_FOR_TILES) - MARGIN_FOR_TILES));
+            cell.setPosition(cellY * cellPixels, cellX * cellPixels);
+            cell.setFillColor(sf::Color(color.r, color.g, color.b, static_cast<sf::Uint8>(opacity * maxAlpha)));
+            overlayCells.push_back(cell);
+        }
+    }
+}
+
+// Removes the overlay.
+void Visualizer::clearOverlay() {
+    overlayCells.clear();
+}
+
 
 // Redraws all visual elements in the window, including tiles and buttons.
 void Visualizer::redrawElements() {
@@ -246,6 +308,10 @@ void Visualizer::redrawElements() {
         }
     }
 
+    for (const auto& cell : overlayCells) {
+        window.draw(cell);
+    }
+
     for (size_t i = 0; i < buttons.size(); ++i) {
         window.draw(buttons[i]);
         window.draw(buttonLabels[i]);
@@ -0,0 +1,113 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+// Weather at one step of a run.
+struct WeatherState {
+    float windSpeed = 5.0f;
+    int windDirection = 0;
+    float dryingRate = 0.0f; // Moisture points tiles lose per step, negative values wet them
+    float moistureOffset = 0.0f; // Moisture points lost in total since the start of the run
+};
+
+// Drying of fuel moisture over the run. Moisture approaches the equilibrium exponentially with time, and every spread attempt from a
+// burning neighbor pre-heats the tile, drying it further. Tile moisture is evaluated lazily, only when fire reaches a tile.
+struct FuelDryingSettings {
+    float equilibriumMoisture = 20.0f; // Moisture tiles dry (or wet) towards
+    float dryingRate = 0.002f; // Fraction of the gap to the equilibrium closed per step
+    float preheat = 3.0f; // Moisture points a tile loses per spread attempt it survives
+};
+
+// Weather keyframe, taking effect from its step on.
+struct WeatherKeyframe {
+    int step;
+    float windSpeed;
+    int windDirection;
+    float dryingRate;
+};
+
+// Timeline of the weather during a run, e.g. day/night cycles and wind shifts. Wind speed and direction are interpolated linearly between
+// keyframes (direction along the shorter way around), the drying rate holds from its keyframe until the next one.
+class WeatherSchedule {
+    std::vector<WeatherKeyframe> keyframes_;
+
+public:
+    WeatherSchedule() = default;
+
+    explicit WeatherSchedule(std::vector<WeatherKeyframe> keyframes) {
+        for (const auto& keyframe : keyframes) {
+            AddKeyframe(keyframe);
+        }
+    }
+
+    // Adds a keyframe, keeping the keyframes ordered by step. A keyframe at an existing step replaces it.
+    void AddKeyframe(const WeatherKeyframe& keyframe) {
+        if (keyframe.windSpeed < 0 || keyframe.windDirection < 0 || keyframe.windDirection > 360) {
+            throw std::invalid_argument("Weather keyframe out of range");
+        }
+        auto it = std::lower_bound(keyframes_.begin(), keyframes_.end(), keyframe.step,
+                                   [](const WeatherKeyframe& existing, int step) { return existing.step < step; });
+        if (it != keyframes_.end() && it->step == keyframe.step) {
+            *it = keyframe;
+        } else {
+            keyframes_.insert(it, keyframe);
+        }
+    }
+
+    bool IsEmpty() const {
+        return keyframes_.empty();
+    }
+
+    const std::vector<WeatherKeyframe>& GetKeyframes() const {
+        return keyframes_;
+    }
+
+    // Weather at the given step. The moisture offset is the closed-form sum of the drying rates of steps 1 to step.
+    WeatherState Sample(int step) const {
+        WeatherState state;
+        if (keyframes_.empty()) {
+            return state;
+        }
+
+        auto next = std::upper_bound(keyframes_.begin(), keyframes_.end(), step,
+                                     [](int step, const WeatherKeyframe& keyframe) { return step < keyframe.step; });
+        if (next == keyframes_.begin()) {
+            state.windSpeed = next->windSpeed;
+            state.windDirection = next->windDirection;
+        } else {
+            const WeatherKeyframe& previous = *(next - 1);
+            state.dryingRate = previous.dryingRate;
+            if (next == keyframes_.end()) {
+                state.windSpeed = previous.windSpeed;
+                state.windDirection = previous.windDirection;
+            } else {
+                float t = static_cast<float>(step - previous.step) / static_cast<float>(next->step - previous.step);
+                state.windSpeed = previous.windSpeed + (next->windSpeed - previous.windSpeed) * t;
+                state.windDirection = InterpolateDirection(previous.windDirection, next->windDirection, t);
+            }
+        }
+
+        for (std::size_t i = 0; i < keyframes_.size() && keyframes_[i].step <= step; ++i) {
+            int from = std::max(keyframes_[i].step, 1);
+            int to = i + 1 < keyframes_.size() ? std::min(step, keyframes_[i + 1].step - 1) : step;
+            if (to >= from) {
+                state.moistureOffset += keyframes_[i].dryingRate * static_cast<float>(to - from + 1);
+            }
+        }
+        return state;
+    }
+
+private:
+    static int InterpolateDirection(int from, int to, float t) {
+        float difference = static_cast<float>(to - from);
+        if (difference > 180) {
+            difference -= 360;
+        } else if (difference < -180) {
+            difference += 360;
+        }
+        int direction = static_cast<int>(std::lround(from + difference * t)) % 360;
+        return direction < 0 ? direction + 360 : direction;
+    }
+};
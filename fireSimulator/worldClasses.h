@@ -6,6 +6,15 @@
 #include <stdexcept>
 #include <random>
 #include <cmath> // for std::max
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 
 
 // Parameter class for changeable properties within the simulation
@@ -40,9 +49,15 @@ public:
     }
 };
 
+// Template class for per-tile parameters, one value for each tile of the world. Flags (bool) are stored one byte per tile, so the whole
+// plane is a contiguous buffer that can be copied or serialized in bulk.
 template<typename T>
 class TypedVectorParameter {
-    std::vector<T> values_;
+public:
+    using Storage = typename std::conditional<std::is_same<T, bool>::value, uint8_t, T>::type;
+
+private:
+    std::vector<Storage> values_;
     T initialValue_;
     T minValue_;
     T maxValue_;
@@ -68,6 +83,19 @@ public:
     void Reset() {
         std::fill(values_.begin(), values_.end(), initialValue_);
     }
+
+    std::size_t Size() const {
+        return values_.size();
+    }
+
+    // Raw access to the whole plane for bulk reads and writes. Values written this way are not clamped.
+    Storage* Data() {
+        return values_.data();
+    }
+
+    const Storage* Data() const {
+        return values_.data();
+    }
 };
 
 // Container for managing parameters. Manages a collection of parameters, allowing adding and retrieving typed parameters.
@@ -152,18 +180,80 @@ private:
     VegetationType vegetation_;
 };
 
+// Terrain of a whole world as flat arrays in tile index order (x * depth + y), for kernels that should not chase Tile pointers.
+struct TerrainPlanes {
+    int width = 0;
+    int depth = 0;
+    std::vector<float> height;
+    std::vector<uint8_t> moisture;
+    std::vector<VegetationType> vegetation;
+
+    std::size_t Size() const {
+        return height.size();
+    }
+};
+
 // World-class - Contains a 2D grid of Tile pointers, managing the terrain layout.
 class World : public ParameterContainer {
 public:
     std::vector<std::vector<Tile*>> grid; // 2D grid of Tile pointers
 
-    World(int width, int depth) : width_(std::max(0, width)), depth_(std::max(0, depth)) {
+    World(int width, int depth)
+            : width_(std::max(0, width)), depth_(std::max(0, depth)), tileArena_(new TileSlot[static_cast<std::size_t>(width_) * depth_]) {
         grid.resize(width_);
         for (int i = 0; i < width_; ++i) {
             grid[i].resize(depth_, nullptr); // Initialize with null pointers or actual Tile objects
         }
     }
 
+    // The world owns its tiles
+    ~World() {
+        for (auto& row : grid) {
+            for (auto* tile : row) {
+                DestroyTile(tile);
+            }
+        }
+    }
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // Creates a new world with copies of all tiles' terrain (height, moisture, vegetation), but none of the parameters.
+    // Cheap compared to generating the world again, so one generated world can be shared by many independent simulation runs.
+    std::shared_ptr<World> CopyTerrain() const {
+        auto copy = std::make_shared<World>(width_, depth_);
+        for (int x = 0; x < width_; ++x) {
+            for (int y = 0; y < depth_; ++y) {
+                const Tile* tile = grid[x][y];
+                if (tile != nullptr) {
+                    copy->EmplaceTile(x, y, tile->GetHeight(), tile->GetMoisture(), tile->GetVegetation());
+                }
+            }
+        }
+        return copy;
+    }
+
+    // Copies the terrain of all tiles into flat planes.
+    TerrainPlanes GetTerrainPlanes() const {
+        TerrainPlanes planes;
+        planes.width = width_;
+        planes.depth = depth_;
+        std::size_t totalTiles = static_cast<std::size_t>(width_) * depth_;
+        planes.height.resize(totalTiles);
+        planes.moisture.resize(totalTiles);
+        planes.vegetation.resize(totalTiles);
+        for (int x = 0; x < width_; ++x) {
+            for (int y = 0; y < depth_; ++y) {
+                const Tile* tile = grid[x][y];
+                std::size_t index = static_cast<std::size_t>(x) * depth_ + y;
+                planes.height[index] = tile->GetHeight();
+                planes.moisture[index] = static_cast<uint8_t>(tile->GetMoisture());
+                planes.vegetation[index] = tile->GetVegetation();
+            }
+        }
+        return planes;
+    }
+
     std::tuple<int, int> GetTilesDistanceXY(Tile* tile1, Tile* tile2) {
         int xDiff = tile1->GetWidthPosition() - tile2->GetWidthPosition();
         int yDiff = tile1->GetDepthPosition() - tile2->GetDepthPosition();
@@ -181,10 +271,22 @@ public:
         if (x < 0 || x >= width_ || y < 0 || y >= depth_) {
             throw std::out_of_range("Coordinates are out of the grid bounds.");
         }
-        delete grid[x][y]; // Clean up the existing tile if necessary
+        DestroyTile(grid[x][y]); // Clean up the existing tile if necessary
         grid[x][y] = tile; // Place the new tile
     }
 
+    // Constructs a tile in the world's tile block instead of allocating it on its own, replacing the tile at (x, y). Every position has its
+    // own slot, so tiles at different positions can be emplaced concurrently.
+    Tile* EmplaceTile(int x, int y, float height, int moisture, VegetationType vegetation) {
+        if (x < 0 || x >= width_ || y < 0 || y >= depth_) {
+            throw std::out_of_range("Coordinates are out of the grid bounds.");
+        }
+        DestroyTile(grid[x][y]);
+        Tile* tile = new (&tileArena_[static_cast<std::size_t>(x) * depth_ + y]) Tile(height, moisture, vegetation, x, y);
+        grid[x][y] = tile;
+        return tile;
+    }
+
     // Method for accessing neighboring tiles.
     std::vector<Tile*> GetNeighborTiles(Tile* tile, int distance = 1) {
         std::vector<Tile*> neighbors;
@@ -203,6 +305,20 @@ public:
         return neighbors;
     }
 
+    // Calls visit(neighbor) for the tiles GetNeighborTiles(tile) returns, in the same order, without building a vector.
+    template <typename Visitor>
+    void ForEachNeighborTile(Tile* tile, Visitor&& visit) {
+        int x = tile->GetWidthPosition();
+        int y = tile->GetDepthPosition();
+        for (int nx = std::max(0, x - 1); nx <= std::min(width_ - 1, x + 1); nx++) {
+            for (int ny = std::max(0, y - 1); ny <= std::min(depth_ - 1, y + 1); ny++) {
+                if (nx != x || ny != y) {
+                    visit(grid[nx][ny]);
+                }
+            }
+        }
+    }
+
     // Method for accessing neighboring tiles neighboring just by the edge of some tile.
     std::vector<Tile*> GetEdgeNeighborTiles(Tile* tile) {
         std::vector<Tile*> edgeNeighbors;
@@ -237,5 +353,25 @@ public:
     }
 
 private:
+    using TileSlot = std::aligned_storage_t<sizeof(Tile), alignof(Tile)>;
+
     int width_, depth_;
+    std::unique_ptr<TileSlot[]> tileArena_; // One slot per position (x * depth + y), pages of unused slots are never touched
+
+    bool IsArenaTile(const Tile* tile) const {
+        const Tile* begin = reinterpret_cast<const Tile*>(tileArena_.get());
+        const Tile* end = begin + static_cast<std::size_t>(width_) * depth_;
+        return !std::less<const Tile*>()(tile, begin) && std::less<const Tile*>()(tile, end);
+    }
+
+    void DestroyTile(Tile* tile) {
+        if (tile == nullptr) {
+            return;
+        }
+        if (IsArenaTile(tile)) {
+            tile->~Tile();
+        } else {
+            delete tile;
+        }
+    }
 };
\ No newline at end of file
@@ -4,7 +4,27 @@
 #include <cmath>
 #include <cstdlib> // For rand()
 #include <ctime> // For time()
+#include <chrono>
+#include <memory>
 #include "perlin.h"
+#include "worldClasses.h"
+#include "taskScheduler.h"
+
+// Calls body(x) for every row x of a map, in parallel when a scheduler is given. Rows must not depend on each other.
+template<typename Body>
+void ForEachMapRow(TaskScheduler* scheduler, int width, Body&& body) {
+    if (scheduler == nullptr) {
+        for (int x = 0; x < width; ++x) {
+            body(x);
+        }
+        return;
+    }
+    scheduler->ParallelFor(0, width, 0, [&body](std::size_t from, std::size_t to) {
+        for (std::size_t x = from; x < to; ++x) {
+            body(static_cast<int>(x));
+        }
+    });
+}
 
 // General template definition. A generic template for 2D maps of any type, supporting basic data manipulation.
 template<typename T>
@@ -122,10 +142,11 @@ class BaseTerrainGenerator : public IMapGenerator<float> {
     int octaves;
     float persistence;
     float scale;
+    TaskScheduler* scheduler;
 
 public:
-    BaseTerrainGenerator(int width, int depth, int octaves = 5, float persistence = 0.4f, float scale = 5.0f) :
-            width(width), depth(depth), octaves(octaves), persistence(persistence), scale(scale) {}
+    BaseTerrainGenerator(int width, int depth, int octaves = 5, float persistence = 0.4f, float scale = 5.0f, TaskScheduler* scheduler = nullptr) :
+            width(width), depth(depth), octaves(octaves), persistence(persistence), scale(scale), scheduler(scheduler) {}
 
     Map<float> Generate() override {
         Map<float> map(width, depth);
@@ -133,7 +154,7 @@ public:
         float offsetX = Random::Range(0, 10000);
         float offsetY = Random::Range(0, 10000);
 
-        for (int x = 0; x < width; x++) {
+        ForEachMapRow(scheduler, width, [&](int x) {
             for (int y = 0; y < depth; y++) {
                 float amplitude = 1.3f;
                 float frequency = 1.1f;
@@ -152,7 +173,7 @@ public:
 
                 map.SetData(x, y, noiseHeight);
             }
-        }
+        });
 
         // Normalize the map data between 0 and 1
         map.Normalize();
@@ -327,6 +348,7 @@ public:
     int depth;
     int rivers;
     float lakeThreshold;
+    TaskScheduler* scheduler = nullptr; // Runs the per-tile passes in parallel when set, the generated world is the same either way
 
     WorldGenerator(int width, int depth, float lakeThreshold, int rivers)
         : width(width), depth(depth), lakeThreshold(lakeThreshold), rivers(rivers) {
@@ -334,8 +356,15 @@ public:
         srand(std::chrono::system_clock::now().time_since_epoch().count()); // Seed the random number generator
     }
 
+    // Generator producing the same world every time for the same seed and settings. Generation uses the global rand() state,
+    // so worlds must not be generated on several threads at once.
+    WorldGenerator(int width, int depth, float lakeThreshold, int rivers, unsigned int seed)
+        : width(width), depth(depth), lakeThreshold(lakeThreshold), rivers(rivers) {
+        Random::InitState(seed);
+    }
+
     std::shared_ptr<World> Generate() {
-        BaseTerrainGenerator heightMapGenerator(width, depth);
+        BaseTerrainGenerator heightMapGenerator(width, depth, 5, 0.4f, 5.0f, scheduler);
         auto heightMap = heightMapGenerator.Generate();
         heightMap.Amplify(0.9f);
 
@@ -360,7 +389,7 @@ private:
     std::shared_ptr<World> GenerateWorldFromMaps(const Map<float>& heightMap, const Map<int>& moistureMap, const Map<VegetationType>& vegetationMap) {
         auto world = std::make_shared<World>(width, depth);
 
-        for (int x = 0; x < width; x++) {
+        ForEachMapRow(scheduler, width, [&](int x) {
             for (int y = 0; y < depth; y++) {
                 float height = heightMap.GetData(x, y);
                 int moisture = moistureMap.GetData(x, y);
@@ -370,13 +399,10 @@ private:
                     height = 0.01f; // Ensure low height for maximum moisture areas / water tiles
                 }
 
-                // Create a new tile with the specified attributes
-                auto currTile = std::make_unique<Tile>(height, moisture, vegetation, x, y);
-
-                // Place the tile in the world at the correct position
-                world->SetTileAt(x, y, new Tile(height, moisture, vegetation, x, y));
+                // Create the tile in place, at its position in the world's tile block
+                world->EmplaceTile(x, y, height, moisture, vegetation);
             }
-        }
+        });
         return world;
     }
 };
\ No newline at end of file